@@ -0,0 +1,23 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <time.h>
+
+// Shared by the programs under bench/: a monotonic clock and one result
+// line per measurement, so runs can be diffed against each other.
+
+static inline double bench_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// name: what was measured; n: repetitions; total_ms: their summed time.
+static inline void bench_report(const char *name, long n, double total_ms, const char *extra) {
+    printf("%-40s %8ld runs %10.3f ms/run%s%s\n", name, n, total_ms / (double)n,
+           extra ? "  " : "", extra ? extra : "");
+    fflush(stdout);
+}
+
+#endif
@@ -0,0 +1,200 @@
+#include "bench.h"
+#include "dock_view.h"
+
+#include <gtk/gtk.h>
+
+// Frame times of a 50-item dock while a synthetic pointer sweeps across
+// it, for the snapshot renderer (with magnification) and for the widget
+// tree it replaces (button > box > image + indicator frame per item,
+// hover restyled through :hover). Work per frame is timed on the frame
+// clock from before-paint to after-paint; the interval between frames is
+// what the compositor saw. Needs a display: without one it is skipped.
+
+#define ITEMS      50
+#define ICON_SIZE  48
+#define FRAMES     600
+#define SWEEP_PX   12.0     // pointer travel per frame
+
+typedef struct {
+    const char *name;
+    GtkWidget *window;
+    GtkWidget *target;          // DockView, or the box of buttons
+    GtkWidget *hovered;
+    double x;
+    double dir;
+    guint frame;
+    gint64 paint_start;
+    gint64 last_frame;
+    GArray *work_us;            // gint64 per frame
+    GArray *interval_us;
+    GMainLoop *loop;
+} Run;
+
+static const char *const icons[] = {
+    "firefox", "org.gnome.Nautilus", "utilities-terminal", "accessories-text-editor",
+    "system-settings", "applications-games", "multimedia-video-player", "web-browser",
+    "mail-client", "accessories-calculator",
+};
+
+static void before_paint(GdkFrameClock *clock, Run *r) {
+    (void)clock;
+    r->paint_start = g_get_monotonic_time();
+}
+
+static void after_paint(GdkFrameClock *clock, Run *r) {
+    gint64 now = g_get_monotonic_time();
+    gint64 work = now - r->paint_start;
+    g_array_append_val(r->work_us, work);
+
+    gint64 ft = gdk_frame_clock_get_frame_time(clock);
+    if (r->last_frame) {
+        gint64 dt = ft - r->last_frame;
+        g_array_append_val(r->interval_us, dt);
+    }
+    r->last_frame = ft;
+}
+
+// Moves the pointer one step and makes the renderer react as it would to
+// a real motion event.
+static gboolean sweep_tick(GtkWidget *w, GdkFrameClock *clock, gpointer data) {
+    (void)w; (void)clock;
+    Run *r = data;
+    int width = gtk_widget_get_width(r->target);
+
+    r->x += r->dir * SWEEP_PX;
+    if (r->x >= width || r->x < 0) {
+        r->dir = -r->dir;
+        r->x = CLAMP(r->x, 0, width - 1);
+    }
+
+    if (DOCK_IS_VIEW(r->target)) {
+        dock_view_hover(DOCK_VIEW(r->target), r->x);
+    } else {
+        GtkWidget *hit = gtk_widget_pick(r->target, r->x, gtk_widget_get_height(r->target) / 2.0, GTK_PICK_DEFAULT);
+        while (hit && !GTK_IS_BUTTON(hit)) hit = gtk_widget_get_parent(hit);
+        if (hit != r->hovered) {
+            if (r->hovered) gtk_widget_unset_state_flags(r->hovered, GTK_STATE_FLAG_PRELIGHT);
+            if (hit) gtk_widget_set_state_flags(hit, GTK_STATE_FLAG_PRELIGHT, FALSE);
+            r->hovered = hit;
+        }
+    }
+    gtk_widget_queue_draw(r->target);
+
+    if (++r->frame < FRAMES) return G_SOURCE_CONTINUE;
+    g_main_loop_quit(r->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static GtkWidget *make_tree(void) {
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+    gtk_widget_add_css_class(box, "dock");
+    for (int i = 0; i < ITEMS; i++) {
+        GtkWidget *btn = gtk_button_new();
+        gtk_button_set_has_frame(GTK_BUTTON(btn), FALSE);
+        gtk_widget_add_css_class(btn, "icon");
+
+        GtkWidget *v = gtk_box_new(GTK_ORIENTATION_VERTICAL, 4);
+        GtkWidget *img = gtk_image_new_from_icon_name(icons[i % G_N_ELEMENTS(icons)]);
+        gtk_image_set_pixel_size(GTK_IMAGE(img), ICON_SIZE);
+
+        GtkWidget *dot = gtk_frame_new(NULL);
+        gtk_widget_add_css_class(dot, "indicator");
+        gtk_widget_set_size_request(dot, 5, 9);
+        gtk_widget_set_halign(dot, GTK_ALIGN_CENTER);
+        gtk_widget_set_opacity(dot, i % 3 ? 0.0 : 1.0);
+
+        gtk_box_append(GTK_BOX(v), img);
+        gtk_box_append(GTK_BOX(v), dot);
+        gtk_button_set_child(GTK_BUTTON(btn), v);
+        gtk_box_append(GTK_BOX(box), btn);
+    }
+    return box;
+}
+
+static GtkWidget *make_view(void) {
+    GtkWidget *view = dock_view_new(ICON_SIZE);
+    for (int i = 0; i < ITEMS; i++) {
+        GIcon *icon = g_themed_icon_new(icons[i % G_N_ELEMENTS(icons)]);
+        DockViewItem *it = dock_view_append(DOCK_VIEW(view), icon, icons[i % G_N_ELEMENTS(icons)], NULL);
+        dock_view_set_dot(DOCK_VIEW(view), it, i % 3 ? 0.0 : 1.0);
+        g_object_unref(icon);
+    }
+    dock_view_set_magnify(DOCK_VIEW(view), 1.6);
+    return view;
+}
+
+static int cmp_i64(gconstpointer a, gconstpointer b) {
+    gint64 x = *(const gint64 *)a, y = *(const gint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(Run *r, const char *what, GArray *a) {
+    if (a->len == 0) return;
+    g_array_sort(a, cmp_i64);
+
+    gint64 sum = 0;
+    for (guint i = 0; i < a->len; i++) sum += g_array_index(a, gint64, i);
+
+    char name[64], extra[64];
+    g_snprintf(name, sizeof name, "dock %s, %s", r->name, what);
+    g_snprintf(extra, sizeof extra, "p95 %.2f ms, max %.2f ms",
+               g_array_index(a, gint64, a->len * 95 / 100) / 1000.0,
+               g_array_index(a, gint64, a->len - 1) / 1000.0);
+    bench_report(name, a->len, sum / 1000.0, extra);
+}
+
+static void run(Run *r, GtkWidget *child) {
+    r->work_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+    r->interval_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+    r->loop = g_main_loop_new(NULL, FALSE);
+    r->dir = 1.0;
+    r->target = child;
+
+    // Headroom above the items, as .dock's top padding gives the real dock;
+    // without it the view caps magnification to 1.0.
+    gtk_widget_set_margin_top(child, ICON_SIZE);
+
+    r->window = gtk_window_new();
+    gtk_window_set_title(GTK_WINDOW(r->window), r->name);
+    gtk_window_set_child(GTK_WINDOW(r->window), child);
+    gtk_widget_realize(r->window);
+    gtk_window_present(GTK_WINDOW(r->window));
+
+    GdkFrameClock *clock = gtk_widget_get_frame_clock(r->window);
+    g_signal_connect(clock, "before-paint", G_CALLBACK(before_paint), r);
+    g_signal_connect(clock, "after-paint", G_CALLBACK(after_paint), r);
+    gtk_widget_add_tick_callback(r->window, sweep_tick, r, NULL);
+
+    g_main_loop_run(r->loop);
+
+    g_signal_handlers_disconnect_by_data(clock, r);
+    report(r, "frame work", r->work_us);
+    report(r, "frame gap", r->interval_us);
+
+    gtk_window_destroy(GTK_WINDOW(r->window));
+    g_array_free(r->work_us, TRUE);
+    g_array_free(r->interval_us, TRUE);
+    g_main_loop_unref(r->loop);
+}
+
+int main(void) {
+    if (!gtk_init_check()) {
+        printf("dock view: no display, skipped\n");
+        return 0;
+    }
+
+    // The dock's own stylesheet, so the widget tree pays its real CSS cost.
+    GtkCssProvider *css = gtk_css_provider_new();
+    gtk_css_provider_load_from_path(css, "data/style.css");
+    gtk_style_context_add_provider_for_display(gdk_display_get_default(), GTK_STYLE_PROVIDER(css),
+                                               GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+
+    Run tree = { .name = "tree" };
+    run(&tree, make_tree());
+
+    Run view = { .name = "snapshot" };
+    run(&view, make_view());
+
+    g_object_unref(css);
+    return 0;
+}
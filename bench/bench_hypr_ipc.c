@@ -0,0 +1,162 @@
+#include "bench.h"
+#include "hypr_ipc.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Per-query latency of the request socket against a stand-in for
+// Hyprland's .socket.sock that answers with canned replies, next to what
+// the dock did before: popen() a command per query. The "before" command
+// is `cat` of the same reply, a lower bound for hyprctl, which also has to
+// connect to the socket itself.
+
+#define CLIENTS 50
+#define QUERIES 2000
+
+static char *clients_json;
+
+static char *make_clients(void) {
+    GString *s = g_string_new("[");
+    for (int i = 0; i < CLIENTS; i++) {
+        g_string_append_printf(s,
+            "%s{\n    \"address\": \"0x%x\",\n    \"workspace\": {\n        \"id\": %d,\n        \"name\": \"%d\"\n    },\n"
+            "    \"monitor\": %d,\n    \"class\": \"org.example.App%d\",\n    \"title\": \"Window %d\",\n"
+            "    \"focusHistoryID\": %d\n}",
+            i ? "," : "", 0x5000 + i, i % 10 + 1, i % 10 + 1, i % 2, i % 20, i, i);
+    }
+    g_string_append(s, "]");
+    return g_string_free(s, FALSE);
+}
+
+// One reply per ';'-separated request, like Hyprland's [[BATCH]].
+static gpointer server_thread(gpointer data) {
+    int lfd = GPOINTER_TO_INT(data);
+    char req[4096];
+
+    for (;;) {
+        int fd = accept(lfd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        ssize_t n = read(fd, req, sizeof req - 1);
+        if (n > 0) {
+            req[n] = '\0';
+            const char *body = g_str_has_prefix(req, "[[BATCH]]") ? req + 9 : req;
+            char **parts = g_strsplit(body, ";", -1);
+
+            GString *out = g_string_new(NULL);
+            for (guint i = 0; parts[i]; i++) {
+                if (i > 0) g_string_append(out, "\n\n\n");
+                g_string_append(out, strcmp(parts[i], "j/clients") == 0 ? clients_json : "[]");
+            }
+            for (gsize off = 0; off < out->len; ) {
+                ssize_t w = write(fd, out->str + off, out->len - off);
+                if (w <= 0) break;
+                off += (gsize)w;
+            }
+            g_string_free(out, TRUE);
+            g_strfreev(parts);
+        }
+        close(fd);
+    }
+    return NULL;
+}
+
+static char *popen_read(const char *cmd) {
+    FILE *p = popen(cmd, "r");
+    if (!p) return NULL;
+
+    GString *s = g_string_new(NULL);
+    char buf[16384];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof buf, p)) > 0) g_string_append_len(s, buf, (gssize)n);
+    pclose(p);
+    return g_string_free(s, FALSE);
+}
+
+int main(void) {
+    clients_json = make_clients();
+
+    // A private runtime dir laid out like Hyprland's.
+    char *runtime = g_dir_make_tmp("bench-hypr-XXXXXX", NULL);
+    char *dir = g_build_filename(runtime, "hypr", "bench", NULL);
+    g_mkdir_with_parents(dir, 0700);
+    g_setenv("XDG_RUNTIME_DIR", runtime, TRUE);
+    g_setenv("HYPRLAND_INSTANCE_SIGNATURE", "bench", TRUE);
+
+    char *sock = hypr_socket_path(".socket.sock");
+    int lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    g_strlcpy(addr.sun_path, sock, sizeof addr.sun_path);
+    if (bind(lfd, (struct sockaddr*)&addr, sizeof addr) < 0 || listen(lfd, 16) < 0) {
+        fprintf(stderr, "cannot listen on %s: %s\n", sock, g_strerror(errno));
+        return 1;
+    }
+    g_thread_unref(g_thread_new("stand-in", server_thread, GINT_TO_POINTER(lfd)));
+
+    char *reply_file = g_build_filename(runtime, "clients.json", NULL);
+    g_file_set_contents(reply_file, clients_json, -1, NULL);
+    char *cmd = g_strdup_printf("cat '%s'", reply_file);
+
+    char extra[64];
+    g_snprintf(extra, sizeof extra, "%zu byte reply", strlen(clients_json));
+
+    // Before: a process per query.
+    double t0 = bench_now_ms();
+    for (int i = 0; i < QUERIES / 10; i++) {
+        char *r = popen_read(cmd);
+        if (!r || strcmp(r, clients_json) != 0) {
+            fprintf(stderr, "popen: wrong reply\n");
+            return 1;
+        }
+        g_free(r);
+    }
+    bench_report("popen j/clients (before)", QUERIES / 10, bench_now_ms() - t0, extra);
+
+    // After: the request socket.
+    t0 = bench_now_ms();
+    for (int i = 0; i < QUERIES; i++) {
+        char *r = hypr_ipc_request("j/clients");
+        if (!r || strcmp(r, clients_json) != 0) {
+            fprintf(stderr, "hypr_ipc_request: wrong reply\n");
+            return 1;
+        }
+        g_free(r);
+    }
+    bench_report("socket j/clients", QUERIES, bench_now_ms() - t0, extra);
+
+    // A resync: four requests, one round trip versus four.
+    static const char *const reqs[] = { "j/clients", "j/workspaces", "j/monitors", "j/activewindow" };
+    t0 = bench_now_ms();
+    for (int i = 0; i < QUERIES; i++) {
+        for (guint j = 0; j < G_N_ELEMENTS(reqs); j++) g_free(hypr_ipc_request(reqs[j]));
+    }
+    bench_report("socket 4 requests, separately", QUERIES, bench_now_ms() - t0, NULL);
+
+    t0 = bench_now_ms();
+    for (int i = 0; i < QUERIES; i++) {
+        char **r = hypr_ipc_batch(reqs, G_N_ELEMENTS(reqs));
+        if (!r || strcmp(r[0], clients_json) != 0) {
+            fprintf(stderr, "hypr_ipc_batch: wrong reply\n");
+            return 1;
+        }
+        g_strfreev(r);
+    }
+    bench_report("socket 4 requests, [[BATCH]]", QUERIES, bench_now_ms() - t0, NULL);
+
+    close(lfd);
+    g_unlink(sock);
+    g_unlink(reply_file);
+    g_rmdir(dir);
+    char *hypr = g_path_get_dirname(dir);
+    g_rmdir(hypr);
+    g_rmdir(runtime);
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "bench.h"
+#include "desktop_index.h"
+#include "icon_pack.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+// First-paint cost of every installed app's theme icon at the default dock
+// and searcher sizes: a theme lookup plus rasterizing, as icon_cache does
+// without a pack, against mapping the pack and making textures from it.
+// The pack is built into a scratch $XDG_CACHE_HOME, so the user's own is
+// left alone. Needs a display for the icon theme: without one it is skipped.
+
+#define BUILD_TIMEOUT_MS 120000
+
+static const int sizes[] = { 32, 64 };     // icon_size, searcher_icon_size
+
+// Theme icon names, as icon_pack_ensure() derives them from the index.
+static GPtrArray *icon_names(const DesktopIndex *apps) {
+    GHashTable *seen = g_hash_table_new(g_str_hash, g_str_equal);
+    GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
+    for (guint i = 0; i < apps->n; i++) {
+        if (desktop_index_flags(apps, i) & DESKTOP_ENTRY_INACTIVE) continue;
+        const char *icon = desktop_index_get(apps, i, DESKTOP_FIELD_ICON);
+        if (!*icon || g_path_is_absolute(icon)) continue;
+
+        gsize len = strlen(icon);
+        if (g_str_has_suffix(icon, ".png") || g_str_has_suffix(icon, ".svg") || g_str_has_suffix(icon, ".xpm")) len -= 4;
+        char *name = g_strndup(icon, len);
+        if (g_hash_table_contains(seen, name)) {
+            g_free(name);
+            continue;
+        }
+        g_hash_table_add(seen, name);
+        g_ptr_array_add(names, name);
+    }
+    g_hash_table_destroy(seen);
+    return names;
+}
+
+// What a named icon costs without the pack. Fallbacks are not counted:
+// the pack does not keep them either.
+static GdkTexture *render(GtkIconTheme *theme, const char *name, int size, int scale) {
+    GtkIconPaintable *icon = gtk_icon_theme_lookup_icon(theme, name, NULL, size, scale, GTK_TEXT_DIR_NONE, 0);
+    GFile *file = gtk_icon_paintable_get_file(icon);
+    char *path = file && g_strcmp0(gtk_icon_paintable_get_icon_name(icon), name) == 0 ? g_file_get_path(file) : NULL;
+    GdkPixbuf *pb = path ? gdk_pixbuf_new_from_file_at_scale(path, size * scale, size * scale, TRUE, NULL) : NULL;
+    GdkTexture *t = pb ? gdk_texture_new_for_pixbuf(pb) : NULL;
+
+    g_clear_object(&pb);
+    g_free(path);
+    g_clear_object(&file);
+    g_object_unref(icon);
+    return t;
+}
+
+static guint lookup_all(GPtrArray *names, int scale) {
+    guint hits = 0;
+    for (guint i = 0; i < names->len; i++) {
+        for (guint s = 0; s < G_N_ELEMENTS(sizes); s++) {
+            GdkTexture *t = icon_pack_lookup(g_ptr_array_index(names, i), sizes[s], scale);
+            if (t) hits++;
+            g_clear_object(&t);
+        }
+    }
+    return hits;
+}
+
+static void remove_tree(const char *path) {
+    GDir *d = g_dir_open(path, 0, NULL);
+    if (d) {
+        const char *name;
+        while ((name = g_dir_read_name(d))) {
+            char *child = g_build_filename(path, name, NULL);
+            remove_tree(child);
+            g_free(child);
+        }
+        g_dir_close(d);
+    }
+    g_remove(path);
+}
+
+// The scale the pack is built for on a single-monitor setup.
+static int display_scale(void) {
+    GListModel *mons = gdk_display_get_monitors(gdk_display_get_default());
+    GdkMonitor *m = g_list_model_get_item(mons, 0);
+    int scale = m ? gdk_monitor_get_scale_factor(m) : 1;
+    g_clear_object(&m);
+    return scale;
+}
+
+int main(void) {
+    char *scratch = g_dir_make_tmp("bench-icon-pack-XXXXXX", NULL);
+    if (!scratch) return 1;
+    g_setenv("XDG_CACHE_HOME", scratch, TRUE);
+
+    if (!gtk_init_check()) {
+        printf("icon pack: no display, skipped\n");
+        g_rmdir(scratch);
+        g_free(scratch);
+        return 0;
+    }
+
+    DesktopIndex *apps = desktop_index_new();
+    GPtrArray *names = icon_names(apps);
+    long n = (long)(names->len * G_N_ELEMENTS(sizes));
+    GtkIconTheme *theme = gtk_icon_theme_get_for_display(gdk_display_get_default());
+    int scale = display_scale();
+
+    double t0 = bench_now_ms();
+    guint rendered = 0;
+    for (guint i = 0; i < names->len; i++) {
+        for (guint s = 0; s < G_N_ELEMENTS(sizes); s++) {
+            GdkTexture *t = render(theme, g_ptr_array_index(names, i), sizes[s], scale);
+            if (t) rendered++;
+            g_clear_object(&t);
+        }
+    }
+    double t1 = bench_now_ms();
+    if (rendered == 0) {
+        printf("icon pack: no app icons in the theme, skipped\n");
+        g_ptr_array_free(names, TRUE);
+        desktop_index_free(apps);
+        remove_tree(scratch);
+        g_free(scratch);
+        return 0;
+    }
+
+    // The build reports back on the main loop and maps the pack it wrote.
+    icon_pack_ensure(apps, sizes, G_N_ELEMENTS(sizes));
+    while (lookup_all(names, scale) == 0 && bench_now_ms() - t1 < BUILD_TIMEOUT_MS) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    double t2 = bench_now_ms();
+
+    // A fresh start: map and validate, then every icon from the pack.
+    icon_pack_load();
+    double t3 = bench_now_ms();
+    guint hits = lookup_all(names, scale);
+    double t4 = bench_now_ms();
+
+    char extra[64];
+    g_snprintf(extra, sizeof extra, "%u of %ld found", rendered, n);
+    bench_report("icon theme lookup + rasterize", n, t1 - t0, extra);
+    bench_report("icon pack build (to mapped)", 1, t2 - t1, NULL);
+    bench_report("icon pack map", 1, t3 - t2, NULL);
+    g_snprintf(extra, sizeof extra, "%u of %ld found", hits, n);
+    bench_report("icon pack lookup", n, t4 - t3, extra);
+
+    g_ptr_array_free(names, TRUE);
+    desktop_index_free(apps);
+    remove_tree(scratch);
+    g_free(scratch);
+    return hits == rendered ? 0 : 1;
+}
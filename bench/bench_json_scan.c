@@ -0,0 +1,90 @@
+#include "bench.h"
+#include "json_scan.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Scans a synthetic j/clients reply of 10k windows, laid out like
+// Hyprland's (pretty-printed, nested workspace object, escaped titles),
+// with the keys hypr.c extracts.
+
+#define CLIENTS 10000
+#define RUNS    50
+
+static const char *const keys[] = {
+    "address", "class", "title", "workspace.id", "workspace.name", "monitor", "focusHistoryID",
+};
+
+typedef struct {
+    long objects;
+    long escaped;
+} Counts;
+
+static void on_object(const JsonScanValue *v, void *user) {
+    Counts *c = user;
+    c->objects++;
+    if (v[2].escaped) c->escaped++;
+}
+
+static char *make_clients(size_t *len) {
+    size_t cap = (size_t)CLIENTS * 1024, n = 0;
+    char *buf = malloc(cap);
+    n += (size_t)snprintf(buf + n, cap - n, "[");
+    for (int i = 0; i < CLIENTS; i++) {
+        n += (size_t)snprintf(buf + n, cap - n,
+            "%s{\n"
+            "    \"address\": \"0x%012x\",\n"
+            "    \"mapped\": true,\n"
+            "    \"hidden\": false,\n"
+            "    \"at\": [%d, %d],\n"
+            "    \"size\": [1280, 720],\n"
+            "    \"workspace\": {\n"
+            "        \"id\": %d,\n"
+            "        \"name\": \"%d\"\n"
+            "    },\n"
+            "    \"floating\": false,\n"
+            "    \"monitor\": %d,\n"
+            "    \"class\": \"org.example.App%d\",\n"
+            "    \"title\": \"%s document %d \\u2014 \\\"draft\\\" - Example Editor\",\n"
+            "    \"initialClass\": \"org.example.App%d\",\n"
+            "    \"initialTitle\": \"Example Editor\",\n"
+            "    \"pid\": %d,\n"
+            "    \"xwayland\": false,\n"
+            "    \"pinned\": false,\n"
+            "    \"fullscreen\": 0,\n"
+            "    \"grouped\": [],\n"
+            "    \"tags\": [],\n"
+            "    \"swallowing\": \"0x0\",\n"
+            "    \"focusHistoryID\": %d\n"
+            "}",
+            i ? "," : "", 0x55550000 + i, i % 1920, i % 1080, i % 10 + 1, i % 10 + 1, i % 3,
+            i % 200, (i % 7) ? "Untitled" : "C:\\\\path\\\\to", i, i % 200, 1000 + i, i);
+    }
+    n += (size_t)snprintf(buf + n, cap - n, "]");
+    *len = n;
+    return buf;
+}
+
+int main(void) {
+    size_t len;
+    char *doc = make_clients(&len);
+
+    Counts c = {0};
+    double t0 = bench_now_ms();
+    for (int r = 0; r < RUNS; r++) {
+        c.objects = 0;
+        if (json_scan_objects(doc, len, keys, (int)(sizeof keys / sizeof *keys), on_object, &c) != CLIENTS) {
+            fprintf(stderr, "json_scan_objects: unexpected result\n");
+            return 1;
+        }
+    }
+    double total = bench_now_ms() - t0;
+
+    char extra[96];
+    snprintf(extra, sizeof extra, "%.1f MiB, %.0f MiB/s",
+             len / 1048576.0, len / 1048576.0 * RUNS / (total / 1000.0));
+    bench_report("json_scan j/clients, 10k windows", RUNS, total, extra);
+
+    free(doc);
+    return 0;
+}
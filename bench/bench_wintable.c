@@ -0,0 +1,91 @@
+#include "bench.h"
+#include "wintable.h"
+#include "intern.h"
+
+#include <glib.h>
+
+// Builds a window table of several thousand windows from socket2 events
+// alone (no compositor needed) and times what the dock does with it:
+// opening windows, per-class/monitor/workspace lookups, moves and closes.
+
+#define WINDOWS    5000
+#define CLASSES    200
+#define MONITORS   3
+#define WORKSPACES 10
+#define LOOKUPS    1000000
+
+// Formats one event's data into a reused buffer; the table copies what it keeps.
+static const char *ev(const char *fmt, ...) {
+    static char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    g_vsnprintf(buf, sizeof buf, fmt, ap);
+    va_end(ap);
+    return buf;
+}
+
+int main(void) {
+    WinTable *t = wintable_new();
+
+    // Hyprland ids grow across hotplugs; slots must not care.
+    for (int m = 0; m < MONITORS; m++) {
+        wintable_apply_event(t, WIN_EVENT_MONITOR_ADDED, ev("%d,DP-%d,Monitor %d", 40 + m, m, m));
+    }
+    for (int w = 1; w <= WORKSPACES; w++) {
+        wintable_apply_event(t, WIN_EVENT_FOCUSED_MONITOR, ev("DP-%d,%d", w % MONITORS, w));
+        wintable_apply_event(t, WIN_EVENT_CREATE_WORKSPACE, ev("%d,%d", w, w));
+    }
+
+    const char *keys[CLASSES];
+    for (int c = 0; c < CLASSES; c++) keys[c] = intern_lower(ev("org.example.App%d", c));
+
+    double t0 = bench_now_ms();
+    for (int i = 0; i < WINDOWS; i++) {
+        wintable_apply_event(t, WIN_EVENT_OPEN_WINDOW,
+                             ev("%x,%d,org.example.App%d,Window %d", 0x1000 + i, i % WORKSPACES + 1, i % CLASSES, i));
+    }
+    bench_report("openwindow", WINDOWS, bench_now_ms() - t0, NULL);
+    if (t->resync_needed) {
+        fprintf(stderr, "table asked for a resync while being filled\n");
+        return 1;
+    }
+
+    int slots[MONITORS];
+    for (int m = 0; m < MONITORS; m++) slots[m] = wintable_monitor_slot(t, ev("DP-%d", m));
+
+    long sum = 0;
+    t0 = bench_now_ms();
+    for (int i = 0; i < LOOKUPS; i++) sum += wintable_class_count(t, keys[i % CLASSES]);
+    bench_report("class count", LOOKUPS, bench_now_ms() - t0, NULL);
+
+    t0 = bench_now_ms();
+    for (int i = 0; i < LOOKUPS; i++) sum += wintable_class_count_on(t, keys[i % CLASSES], slots[i % MONITORS]);
+    bench_report("class count on monitor", LOOKUPS, bench_now_ms() - t0, NULL);
+
+    t0 = bench_now_ms();
+    for (int i = 0; i < LOOKUPS; i++) sum += wintable_class_count_ws(t, keys[i % CLASSES], i % WORKSPACES + 1);
+    bench_report("class count on workspace", LOOKUPS, bench_now_ms() - t0, NULL);
+
+    t0 = bench_now_ms();
+    for (int i = 0; i < LOOKUPS / 10; i++) sum += (long)wintable_pick_window(t, keys[i % CLASSES]);
+    bench_report("pick window", LOOKUPS / 10, bench_now_ms() - t0, NULL);
+
+    t0 = bench_now_ms();
+    for (int i = 0; i < WINDOWS; i++) {
+        wintable_apply_event(t, WIN_EVENT_MOVE_WINDOW, ev("%x,%d,%d", 0x1000 + i, (i + 1) % WORKSPACES + 1, (i + 1) % WORKSPACES + 1));
+    }
+    bench_report("movewindowv2", WINDOWS, bench_now_ms() - t0, NULL);
+
+    t0 = bench_now_ms();
+    for (int i = 0; i < WINDOWS; i++) wintable_apply_event(t, WIN_EVENT_CLOSE_WINDOW, ev("%x", 0x1000 + i));
+    bench_report("closewindow", WINDOWS, bench_now_ms() - t0, NULL);
+
+    if (t->wins->len != 0 || wintable_class_count(t, keys[0]) != 0) {
+        fprintf(stderr, "table not empty after closing every window\n");
+        return 1;
+    }
+    printf("(checksum %ld)\n", sum);
+
+    wintable_free(t);
+    return 0;
+}
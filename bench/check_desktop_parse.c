@@ -0,0 +1,187 @@
+#include "bench.h"
+#include "desktop_parse.h"
+
+#include <gio/gdesktopappinfo.h>
+#include <string.h>
+
+// Parses every installed .desktop file with desktop_entry_parse() and with
+// GKeyFile/GDesktopAppInfo, the path it replaced, and compares what the
+// index reads. Prints each difference and fails if there is any; also
+// times both parsers over the same files.
+
+typedef struct {
+    const char *key;
+    gsize offset;
+    enum { STRING, LOCALE_STRING, LIST, BOOLEAN } kind;
+} Field;
+
+#define F(k, f, kind) { k, G_STRUCT_OFFSET(DesktopEntry, f), kind }
+
+static const Field fields[] = {
+    F("Type", type, STRING),
+    F("TryExec", try_exec, STRING),
+    F("Name", name, LOCALE_STRING),
+    F("GenericName", generic_name, LOCALE_STRING),
+    F("Keywords", keywords, LOCALE_STRING),
+    F("Icon", icon, LOCALE_STRING),
+    F("Exec", exec, STRING),
+    F("Path", workdir, STRING),
+    F("StartupWMClass", wm_class, STRING),
+    F("Actions", actions, LIST),
+    F("OnlyShowIn", only_show_in, LIST),
+    F("NotShowIn", not_show_in, LIST),
+    F("Terminal", terminal, BOOLEAN),
+    F("NoDisplay", no_display, BOOLEAN),
+    F("Hidden", hidden, BOOLEAN),
+};
+
+#undef F
+
+static void collect(const char *dir, GPtrArray *out) {
+    GDir *d = g_dir_open(dir, 0, NULL);
+    if (!d) return;
+    const char *name;
+    while ((name = g_dir_read_name(d))) {
+        char *path = g_build_filename(dir, name, NULL);
+        if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+            collect(path, out);
+            g_free(path);
+        } else if (g_str_has_suffix(name, ".desktop")) {
+            g_ptr_array_add(out, path);
+        } else {
+            g_free(path);
+        }
+    }
+    g_dir_close(d);
+}
+
+// Our raw list as g_key_file_get_string_list() would split it.
+static char *join_raw_list(const char *raw) {
+    if (!raw) return NULL;
+    GString *out = g_string_new(NULL);
+    for (const char *p = raw; *p; p++) {
+        if (*p == '\\' && p[1]) g_string_append_c(out, *++p);
+        else if (*p == ';') g_string_append_c(out, '\n');
+        else g_string_append_c(out, *p);
+    }
+    if (out->len && out->str[out->len - 1] == '\n') g_string_truncate(out, out->len - 1);
+    return g_string_free(out, FALSE);
+}
+
+static char *join_list(char **items) {
+    return items ? g_strjoinv("\n", items) : NULL;
+}
+
+static guint mismatches;
+
+static void differ(const char *path, const char *what, const char *ours, const char *theirs) {
+    if (g_strcmp0(ours, theirs) == 0) return;
+    printf("%s: %s: ours '%s', gio '%s'\n", path, what, ours ? ours : "(none)", theirs ? theirs : "(none)");
+    mismatches++;
+}
+
+static void compare(const char *path, const char *const *langs) {
+    DesktopEntry e;
+    gboolean ours = desktop_entry_parse(path, langs, &e);
+
+    GKeyFile *kf = g_key_file_new();
+    gboolean theirs = g_key_file_load_from_file(kf, path, G_KEY_FILE_NONE, NULL);
+    char *start = theirs ? g_key_file_get_start_group(kf) : NULL;
+    theirs = g_strcmp0(start, G_KEY_FILE_DESKTOP_GROUP) == 0;
+    g_free(start);
+
+    differ(path, "accepted", ours ? "yes" : "no", theirs ? "yes" : "no");
+    if (!ours || !theirs) {
+        desktop_entry_clear(&e);
+        g_key_file_free(kf);
+        return;
+    }
+
+    const char *g = G_KEY_FILE_DESKTOP_GROUP;
+    for (guint i = 0; i < G_N_ELEMENTS(fields); i++) {
+        const Field *f = &fields[i];
+        gpointer field = G_STRUCT_MEMBER_P(&e, f->offset);
+        char *a = NULL, *b = NULL;
+        switch (f->kind) {
+        case STRING:
+            a = g_strdup(*(char **)field);
+            b = g_key_file_get_string(kf, g, f->key, NULL);
+            break;
+        case LOCALE_STRING:
+            a = g_strdup(*(char **)field);
+            b = g_key_file_get_locale_string(kf, g, f->key, NULL, NULL);
+            break;
+        case LIST: {
+            a = join_raw_list(*(char **)field);
+            char **items = g_key_file_get_string_list(kf, g, f->key, NULL, NULL);
+            b = join_list(items);
+            g_strfreev(items);
+            break;
+        }
+        case BOOLEAN:
+            a = g_strdup(*(gboolean *)field ? "true" : "false");
+            b = g_strdup(g_key_file_get_boolean(kf, g, f->key, NULL) ? "true" : "false");
+            break;
+        }
+        differ(path, f->key, a, b);
+        g_free(a);
+        g_free(b);
+    }
+
+    // What the dock used to read through GDesktopAppInfo, where it loads.
+    GDesktopAppInfo *info = g_desktop_app_info_new_from_keyfile(kf);
+    if (info) {
+        if (e.name) differ(path, "g_app_info_get_name", e.name, g_app_info_get_name(G_APP_INFO(info)));
+        differ(path, "g_app_info_get_commandline", e.exec, g_app_info_get_commandline(G_APP_INFO(info)));
+        differ(path, "get_generic_name", e.generic_name, g_desktop_app_info_get_generic_name(info));
+        differ(path, "get_startup_wm_class", e.wm_class, g_desktop_app_info_get_startup_wm_class(info));
+        differ(path, "get_nodisplay", e.no_display ? "true" : "false",
+               g_desktop_app_info_get_nodisplay(info) ? "true" : "false");
+        g_object_unref(info);
+    }
+
+    desktop_entry_clear(&e);
+    g_key_file_free(kf);
+}
+
+int main(void) {
+    GPtrArray *paths = g_ptr_array_new_with_free_func(g_free);
+    char *user = g_build_filename(g_get_user_data_dir(), "applications", NULL);
+    collect(user, paths);
+    g_free(user);
+    for (const char *const *d = g_get_system_data_dirs(); *d; d++) {
+        char *dir = g_build_filename(*d, "applications", NULL);
+        collect(dir, paths);
+        g_free(dir);
+    }
+    if (paths->len == 0) {
+        printf("desktop parse: no .desktop files installed, skipped\n");
+        g_ptr_array_free(paths, TRUE);
+        return 0;
+    }
+
+    const char *const *langs = g_get_language_names();
+    for (guint i = 0; i < paths->len; i++) compare(g_ptr_array_index(paths, i), langs);
+
+    // Both parsers over the same files, with the page cache warm.
+    double t0 = bench_now_ms();
+    for (guint i = 0; i < paths->len; i++) {
+        DesktopEntry e;
+        desktop_entry_parse(g_ptr_array_index(paths, i), langs, &e);
+        desktop_entry_clear(&e);
+    }
+    double t1 = bench_now_ms();
+    for (guint i = 0; i < paths->len; i++) {
+        GDesktopAppInfo *info = g_desktop_app_info_new_from_filename(g_ptr_array_index(paths, i));
+        if (info) g_object_unref(info);
+    }
+    double t2 = bench_now_ms();
+
+    bench_report("desktop_entry_parse", paths->len, t1 - t0, NULL);
+    bench_report("g_desktop_app_info_new_from_filename", paths->len, t2 - t1, NULL);
+
+    printf("desktop parse: %u files, %u differences\n", paths->len, mismatches);
+
+    g_ptr_array_free(paths, TRUE);
+    return mismatches ? 1 : 0;
+}
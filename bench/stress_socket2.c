@@ -0,0 +1,202 @@
+#include "bench.h"
+#include "line_framer.h"
+#include "event_queue.h"
+
+#include <glib.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+// Stands in for Hyprland's socket2: a writer thread emits events over a
+// socketpair at a fixed rate, cut into arbitrary write() sizes, and the
+// reader runs them through line_framer and event_queue exactly as the
+// event thread does. Every line carries a sequence number and a body
+// derived from it, so the consumer can tell a torn or lost line from a
+// good one.
+//
+// Phase 1 drains as fast as the main loop would: nothing may be lost.
+// Phase 2 stalls the consumer: the queue must overflow and say so, which
+// is what makes hypr_events resync, and every line that did get through
+// must still be intact.
+
+#define RATE_PER_S   100000
+#define SECONDS      2
+#define TICK_US      1000
+
+typedef struct {
+    int fd;
+    guint total;
+} Writer;
+
+// Title lengths vary up to ~400 bytes so lines straddle reads and the ring end.
+static gsize make_line(char *buf, gsize cap, guint seq) {
+    int n = g_snprintf(buf, cap, "windowtitlev2>>%x,", seq);
+    guint body = (seq * 2654435761u) % 400;
+    for (guint i = 0; i < body && (gsize)n < cap - 2; i++) buf[n++] = (char)('a' + (seq + i) % 26);
+    buf[n++] = '\n';
+    buf[n] = '\0';
+    return (gsize)n;
+}
+
+static gboolean write_all(int fd, const char *p, gsize n) {
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return FALSE;
+        p += w;
+        n -= (gsize)w;
+    }
+    return TRUE;
+}
+
+static gpointer writer_thread(gpointer data) {
+    Writer *w = data;
+    guint per_tick = RATE_PER_S / (1000000 / TICK_US);
+    GString *out = g_string_new(NULL);
+    char line[512];
+    guint seq = 0;
+    gint64 next = g_get_monotonic_time();
+
+    while (seq < w->total) {
+        g_string_truncate(out, 0);
+        for (guint i = 0; i < per_tick && seq < w->total; i++) {
+            gsize n = make_line(line, sizeof line, seq++);
+            g_string_append_len(out, line, (gssize)n);
+        }
+
+        // Arbitrary cut points, like a kernel handing back partial buffers.
+        gsize off = 0;
+        while (off < out->len) {
+            gsize cut = (gsize)g_random_int_range(1, 8192);
+            gsize n = MIN(out->len - off, cut);
+            if (!write_all(w->fd, out->str + off, n)) goto done;
+            off += n;
+        }
+
+        next += TICK_US;
+        gint64 now = g_get_monotonic_time();
+        if (next > now) g_usleep((gulong)(next - now));
+    }
+done:
+    g_string_free(out, TRUE);
+    shutdown(w->fd, SHUT_WR);
+    return NULL;
+}
+
+typedef struct {
+    int fd;
+    EventQueue *q;
+    guint lines;
+    gint done;          // atomic
+} Reader;
+
+// The event thread's read loop, minus classification.
+static gpointer reader_thread(gpointer data) {
+    Reader *r = data;
+    LineFramer *fr = line_framer_new();
+    struct pollfd p = { .fd = r->fd, .events = POLLIN };
+
+    for (;;) {
+        if (poll(&p, 1, -1) < 0 && errno != EINTR) break;
+
+        gsize avail = 0;
+        char *dst = line_framer_reserve(fr, &avail);
+        ssize_t n = read(r->fd, dst, avail);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        if (n <= 0) break;
+        line_framer_commit(fr, (gsize)n);
+
+        const char *line;
+        gsize len;
+        while (line_framer_next(fr, &line, &len)) {
+            const char *sep = memchr(line, '>', len);
+            gsize off = sep ? (gsize)(sep - line) + 2 : 0;
+            event_queue_push(r->q, 1, 0, g_get_monotonic_time(), line + off, len - off);
+            r->lines++;
+        }
+    }
+
+    line_framer_free(fr);
+    g_atomic_int_set(&r->done, 1);
+    return NULL;
+}
+
+typedef struct {
+    guint got;
+    guint torn;
+    guint gaps;         // runs of missing sequence numbers
+    guint next_seq;
+} Check;
+
+static void check_slot(Check *c, const EventSlot *ev) {
+    char want[512];
+    guint seq = (guint)g_ascii_strtoull(ev->data, NULL, 16);
+    gsize n = make_line(want, sizeof want, seq);
+    const char *body = strstr(want, ">>") + 2;
+
+    if (ev->len != n - (gsize)(body - want) - 1 || memcmp(ev->data, body, ev->len) != 0) c->torn++;
+    if (seq != c->next_seq) c->gaps++;
+    c->next_seq = seq + 1;
+    c->got++;
+}
+
+// stall_us: how long the consumer sleeps between drains (0 = keep up).
+static gboolean run(const char *name, guint total, gulong stall_us, gboolean expect_loss) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+        fprintf(stderr, "socketpair: %s\n", g_strerror(errno));
+        return FALSE;
+    }
+
+    EventQueue *q = event_queue_new();
+    Writer w = { .fd = sv[0], .total = total };
+    Reader r = { .fd = sv[1], .q = q };
+    Check c = { 0 };
+    gboolean overflowed = FALSE;
+
+    double t0 = bench_now_ms();
+    GThread *wt = g_thread_new("fake-socket2", writer_thread, &w);
+    GThread *rt = g_thread_new("reader", reader_thread, &r);
+
+    for (;;) {
+        gboolean finished = g_atomic_int_get(&r.done);
+        const EventSlot *ev;
+        while ((ev = event_queue_peek(q))) {
+            check_slot(&c, ev);
+            event_queue_pop(q);
+        }
+        if (event_queue_take_overflow(q)) overflowed = TRUE;
+        if (finished && !event_queue_peek(q)) break;
+        g_usleep(stall_us ? stall_us : 100);
+    }
+    double ms = bench_now_ms() - t0;
+
+    g_thread_join(wt);
+    g_thread_join(rt);
+    close(sv[0]);
+    close(sv[1]);
+    event_queue_free(q);
+
+    char extra[160];
+    g_snprintf(extra, sizeof extra, "%u sent, %u framed, %u delivered, %u torn, %u gaps, overflow %s",
+               total, r.lines, c.got, c.torn, c.gaps, overflowed ? "yes" : "no");
+    bench_report(name, 1, ms, extra);
+
+    gboolean ok = c.torn == 0 && r.lines == total;
+    if (expect_loss) ok = ok && overflowed && c.gaps > 0;
+    else ok = ok && !overflowed && c.gaps == 0 && c.got == total;
+    if (!ok) fprintf(stderr, "%s: FAILED\n", name);
+    return ok;
+}
+
+int main(void) {
+    guint total = RATE_PER_S * SECONDS;
+    gboolean ok = TRUE;
+
+    ok &= run("socket2 100k/s, draining", total, 0, FALSE);
+    ok &= run("socket2 100k/s, stalled consumer", total / 4, 50000, TRUE);
+
+    return ok ? 0 : 1;
+}
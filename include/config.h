@@ -3,10 +3,31 @@
 
 #include <gtk/gtk.h>
 
+typedef enum {
+	DOCK_CLICK_LAUNCH,	// always start a new instance
+	DOCK_CLICK_FOCUS,		// focus (and cycle) existing windows; launch if none
+} DockClickAction;
+
+typedef enum {
+	DOCK_RENDER_WIDGETS,	// a GtkButton subtree per item, styled by style.css
+	DOCK_RENDER_SNAPSHOT,	// one DockView widget drawing every item itself
+} DockRenderer;
+
 typedef struct {
 	gchar **pinned_apps;
 	int icon_size;
 	int searcher_icon_size;
+	int refresh_debounce_ms;	// trailing quiet period before indicator updates
+	DockClickAction click_action;
+	gboolean show_running;		// list running unpinned apps after the pinned ones
+	DockRenderer renderer;		// read at startup only
+	double magnify;						// hover magnification (renderer=snapshot); 1.0 = off
+	gsize icon_cache_bytes;		// [icons] cache_budget_kb, shared by dock and searcher
+
+	// Polling fallback (event socket unavailable)
+	int poll_min_ms;
+	int poll_max_ms;
+	double poll_backoff;
 } DockConfig;
 
 
@@ -0,0 +1,130 @@
+#ifndef DESKTOP_INDEX_H
+#define DESKTOP_INDEX_H
+
+#include <gio/gio.h>
+
+// Every installed application entry, read once per session from the XDG
+// application dirs and queried by the dock, searcher and launcher instead
+// of each going through GDesktopAppInfo.
+//
+// Entries are stored as a struct of arrays: one column per field, each a
+// 32-bit offset into a single blob of interned, NUL-terminated strings
+// (offset 0 is ""). Identical values, such as shared icon names or Exec
+// lines, are stored once.
+//
+// The same layout is saved to $XDG_CACHE_HOME/simple-gui/desktop-index.bin
+// and mmap'ed on the next start: if no application dir's mtime changed,
+// the columns point straight into the mapping. Otherwise only the dirs
+// that changed are read again, along with entries whose TryExec may now
+// resolve differently (a dir it was looked for in changed). Files that
+// are read are parsed on a few worker threads (see desktop_parse.h) and
+// merged in scan order.
+
+typedef enum {
+    DESKTOP_FIELD_ID,           // desktop id, e.g. "org.gnome.Nautilus.desktop"
+    DESKTOP_FIELD_NAME,         // localized
+    DESKTOP_FIELD_GENERIC_NAME, // localized
+    DESKTOP_FIELD_KEYWORDS,     // localized, ';'-separated as in the file
+    DESKTOP_FIELD_ICON,         // theme name or absolute path
+    DESKTOP_FIELD_EXEC,
+    DESKTOP_FIELD_WORKDIR,      // Path=
+    DESKTOP_FIELD_WM_CLASS,     // StartupWMClass
+    DESKTOP_FIELD_ACTIONS,      // ';'-separated action ids as in the file
+    DESKTOP_FIELD_TRY_EXEC,     // kept on masked entries too, to check it again
+    DESKTOP_FIELD_MATCH_KEY,    // desktop_match_key_from(wm class, id)
+    DESKTOP_FIELD_SEARCH_KEY,   // lowercased name, generic name, keywords and id
+    DESKTOP_FIELD_FILE,         // where it was read from
+    DESKTOP_N_FIELDS
+} DesktopField;
+
+enum {
+    DESKTOP_ENTRY_TERMINAL = 1 << 0,    // Terminal=true
+    DESKTOP_ENTRY_SHOW     = 1 << 1,    // not NoDisplay, and OnlyShowIn/NotShowIn allow it
+    DESKTOP_ENTRY_MASKED   = 1 << 2,    // Hidden, not an application, or TryExec missing
+    DESKTOP_ENTRY_SHADOWED = 1 << 3,    // an earlier dir has the same id
+};
+
+// Masked and shadowed entries are kept (only to re-derive shadowing when a
+// single dir is rescanned) but are never returned by the lookups.
+#define DESKTOP_ENTRY_INACTIVE (DESKTOP_ENTRY_MASKED | DESKTOP_ENTRY_SHADOWED)
+
+typedef enum {
+    DESKTOP_INDEX_COLD,         // no usable cache: every dir was read
+    DESKTOP_INDEX_PARTIAL,      // cache used for the dirs that did not change
+    DESKTOP_INDEX_WARM,         // used the mapped cache as is
+} DesktopIndexSource;
+
+typedef struct {
+    guint n;                                // entries, including inactive ones
+    const guint32 *cols[DESKTOP_N_FIELDS];  // string offsets, n per column
+    const guint8 *flags;                    // DESKTOP_ENTRY_*, n of them
+    const char *strings;                    // the string blob
+    GHashTable *by_id;              // char* id -> index + 1 (keys point into strings)
+    GHashTable *by_key;             // char* match key -> index + 1, first entry wins
+    GPtrArray *icons;               // GIcon*, built on first use; NULL until then
+    GPtrArray *app_infos;           // GDesktopAppInfo*, loaded on first launch; NULL until then
+
+    DesktopIndexSource source;
+    guint dirs_read;                // dirs listed and parsed rather than taken from the cache
+    char **dirs;                    // every applications dir scanned, nested ones too
+
+    // Backing storage for the columns: the mapped cache file, or arrays
+    // built in memory (NULL when mapped).
+    GMappedFile *map;
+    GArray *own_cols[DESKTOP_N_FIELDS];
+    GArray *own_flags;
+    GString *own_strings;
+} DesktopIndex;
+
+// Scans $XDG_DATA_HOME and $XDG_DATA_DIRS; earlier dirs shadow later ones.
+// Uses and refreshes the on-disk cache.
+DesktopIndex *desktop_index_new(void);
+void desktop_index_free(DesktopIndex *idx);
+
+// A new index from the cache the current one wrote, reading again only the
+// dirs whose mtime changed and dirty_dirs (char* path set, may be NULL),
+// where files were rewritten in place.
+DesktopIndex *desktop_index_update(GHashTable *dirty_dirs);
+
+typedef enum {
+    DESKTOP_CHANGE_ADDED,
+    DESKTOP_CHANGE_REMOVED,         // no longer installed, hidden or shadowed
+    DESKTOP_CHANGE_CHANGED,         // any field or flag differs
+} DesktopChangeKind;
+
+typedef struct {
+    DesktopChangeKind kind;
+    const char *id;                 // borrowed from whichever index has it
+    int old_i;                      // entry in the old index, or -1
+    int new_i;                      // entry in the new index, or -1
+} DesktopChange;
+
+// DesktopChange per active desktop id that differs; valid while both live.
+GArray *desktop_index_diff(const DesktopIndex *old, const DesktopIndex *new);
+
+// Moves what old already loaded for entries that are not in changes (as
+// returned by desktop_index_diff()) over to new, so they are not read again.
+void desktop_index_carry_over(DesktopIndex *new, DesktopIndex *old, const GArray *changes);
+
+// Entry index for a desktop id or match key, or -1.
+int desktop_index_lookup(const DesktopIndex *idx, const char *desktop_id);
+int desktop_index_lookup_key(const DesktopIndex *idx, const char *match_key);
+
+// Borrowed; valid as long as idx. Never NULL.
+const char *desktop_index_get(const DesktopIndex *idx, guint i, DesktopField field);
+guint desktop_index_flags(const DesktopIndex *idx, guint i);
+
+// Active and meant to be listed (the searcher's app grid).
+gboolean desktop_index_listed(const DesktopIndex *idx, guint i);
+
+// The entry's icon (borrowed, shared by every caller), or NULL if it has none.
+GIcon *desktop_index_icon(DesktopIndex *idx, guint i);
+
+// A GDesktopAppInfo for the entry (borrowed), loaded from its file the
+// first time it is asked for and kept for the life of the index; NULL if
+// the file cannot be loaded.
+GAppInfo *desktop_index_app_info(DesktopIndex *idx, guint i);
+
+const char *desktop_index_source_name(DesktopIndexSource source);
+
+#endif
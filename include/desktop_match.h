@@ -1,11 +1,22 @@
 #ifndef DESKTOP_MATCH_H
 #define DESKTOP_MATCH_H
 
+#include "desktop_index.h"
+
 // G_BEGIN_DECLS
 
-// Returns a lowercase key used to match Hyprland "class" to a desktop entry.
-// Caller owns the returned string (free with g_free()).
-char *desktop_match_key(const char *desktop_id);
+// Lowercase key used to match a Hyprland "class" to a desktop entry: the
+// entry's StartupWMClass (wm_class, may be NULL), else its id without
+// ".desktop". Caller owns the returned string (free with g_free()).
+char *desktop_match_key_from(const char *wm_class, const char *desktop_id);
+
+// Same for an id, looked up in apps; ids not installed fall back to the id.
+// Interned (intern_lower()): compare with ==, never free.
+const char *desktop_match_key(const DesktopIndex *apps, const char *desktop_id);
+
+// Finds the desktop id whose match key is cls (a lowercased Hyprland class),
+// or NULL. The result is borrowed from apps.
+const char *desktop_match_resolve_class(const DesktopIndex *apps, const char *cls);
 
 // G_END_DECLS
 
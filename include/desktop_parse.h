@@ -0,0 +1,39 @@
+#ifndef DESKTOP_PARSE_H
+#define DESKTOP_PARSE_H
+
+#include <glib.h>
+
+// The [Desktop Entry] keys the desktop index uses, read straight from the
+// mmap'ed file. Everything else (other groups, locales that do not apply,
+// keys we never look at) is skipped without being copied. Values come out
+// as GKeyFile would return them: the last occurrence of a key wins, and a
+// value with an invalid escape counts as missing. Safe to call from
+// several threads at once.
+typedef struct {
+    char *type;
+    char *try_exec;
+    char *name;             // localized: best match in langs
+    char *generic_name;     // localized
+    char *keywords;         // localized, raw ';'-separated list
+    char *icon;             // localized
+    char *exec;
+    char *workdir;          // Path
+    char *wm_class;         // StartupWMClass
+    char *actions;          // raw ';'-separated list; \; and \\ left escaped
+    char *only_show_in;     // raw ';'-separated lists, likewise
+    char *not_show_in;
+    gboolean terminal;
+    gboolean no_display;
+    gboolean hidden;
+} DesktopEntry;
+
+// langs is g_get_language_names() as read on the main thread (best first,
+// ending in "C"). Returns FALSE if the file cannot be read, is not a valid
+// key file or does not start with [Desktop Entry]; out is cleared either way.
+gboolean desktop_entry_parse(const char *path, const char *const *langs, DesktopEntry *out);
+void desktop_entry_clear(DesktopEntry *e);
+
+// Whether a raw ';'-separated list (as in OnlyShowIn) names any of names.
+gboolean desktop_list_contains_any(const char *list, char **names);
+
+#endif
@@ -3,22 +3,73 @@
 
 #include <gtk/gtk.h>
 #include "state.h"
+#include "dock_view.h"
 
+typedef enum {
+    DOCK_DOT_NONE,      // no windows
+    DOCK_DOT_ELSEWHERE, // windows only on other monitors
+    DOCK_DOT_HERE,      // windows on the dock's monitor
+} DockDotLevel;
+
+// One dock window per monitor. All of them show the same items; a surface
+// only owns its widgets.
+typedef struct {
+    AppState *st;
+    guint slot;             // index in st->docks and in each item's widgets
+    GdkMonitor *monitor;
+    GtkWidget *window;
+    GtkWidget *box;         // .dock box
+    GtkWidget *view;        // DockView inside box with renderer=snapshot, else NULL
+    GtkWidget *running_sep; // separator before the running apps; NULL until needed
+    int icon_size;          // what this dock's icons currently use
+} DockSurface;
+
+// What one dock shows for an item, so updates only touch what changed.
 typedef struct {
-    char *desktop_id;   // e.g. "firefox.desktop"
-    char *match_key;    // lowercased StartupWMClass or desktop-id fallback
+    // renderer=widgets
+    GtkWidget *button;  // gets the "focused" class while the app has focus
+    GtkWidget *icon;    // GtkImage, or a GtkLabel if the entry was not found
     GtkWidget *dot;     // indicator widget
+
+    // renderer=snapshot (the widgets above are NULL)
+    DockViewItem *cell;
+
+    DockDotLevel level; // per dock: it depends on the dock's monitor
+    gboolean focused;
+} DockItemWidgets;
+
+typedef struct {
+    const char *desktop_id; // e.g. "firefox.desktop" (interned)
+    const char *match_key;  // lowercased StartupWMClass or desktop-id fallback (interned)
+    GIcon *gicon;       // shared by every dock; NULL if the entry was not found
+    gboolean dynamic;   // in the running-apps section rather than pinned
+    GArray *widgets;    // DockItemWidgets, indexed by DockSurface slot
 } DockItem;
 
 // typedef struct AppState AppState;
 
 gboolean idle_rebuild_config(gpointer data);
 
-gboolean dock_refresh_running(gpointer user_data);
+// Updates indicators from st->windows without any IPC.
+void dock_apply_running(AppState *st);
+
+// Coalesces update requests: at most one dock_apply_running() per frame,
+// after [dock] refresh_debounce_ms of quiet if that is set.
+void dock_schedule_update(AppState *st);
+
+void dock_log_stats(AppState *st);
 
 void rebuild_dock_from_config(AppState *st);
 
-// Called once after you create the dock box in app.c
+// Has the icon pack rebuilt in the background if it lacks any app icon at
+// the dock or searcher size.
+void dock_update_icon_pack(AppState *st);
+
+// Applies desktop index changes (DesktopChange, see desktop_index_diff())
+// to the items that show those entries.
+void dock_apps_changed(AppState *st, const GArray *changes);
+
+// Builds the items and one dock per monitor, and follows hotplug.
 void dock_init(AppState *st);
 
 void dock_shutdown(AppState *st);
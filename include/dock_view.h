@@ -0,0 +1,47 @@
+#ifndef DOCK_VIEW_H
+#define DOCK_VIEW_H
+
+#include <gtk/gtk.h>
+
+// The whole dock as one widget: items are laid out, drawn (icon + dot) and
+// hit-tested here instead of each being a button/box/image/frame subtree.
+// Selected with [dock] renderer=snapshot.
+
+#define DOCK_TYPE_VIEW (dock_view_get_type())
+G_DECLARE_FINAL_TYPE(DockView, dock_view, DOCK, VIEW, GtkWidget)
+
+typedef struct _DockViewItem DockViewItem;
+
+// button is the mouse button (GDK_BUTTON_PRIMARY, GDK_BUTTON_MIDDLE, ...).
+typedef void (*DockViewActivateFunc)(gpointer item_data, guint button, gpointer user_data);
+
+GtkWidget *dock_view_new(int icon_size);
+void dock_view_set_activate_func(DockView *v, DockViewActivateFunc func, gpointer user_data);
+void dock_view_set_icon_size(DockView *v, int icon_size);
+
+// Hover magnification: the icon under the pointer grows to factor times its
+// size, its neighbours less. Drawn with snapshot transforms only, so the
+// allocation (and the layer's exclusive zone) never changes; the factor is
+// capped to the room above the view in its window. 1.0 turns it off.
+// It switches itself off if frames keep running over budget.
+void dock_view_set_magnify(DockView *v, double factor);
+
+// Magnifies as if the pointer were at x (view coordinates), or nowhere for
+// x < 0. The motion controller feeds this; bench/ drives it directly.
+void dock_view_hover(DockView *v, double x);
+
+// Items. gicon may be NULL, in which case label is drawn instead.
+// prev NULL inserts at the front.
+DockViewItem *dock_view_insert_after(DockView *v, DockViewItem *prev, GIcon *gicon,
+                                     const char *label, gpointer item_data);
+DockViewItem *dock_view_append(DockView *v, GIcon *gicon, const char *label, gpointer item_data);
+void dock_view_remove(DockView *v, DockViewItem *it);
+DockViewItem *dock_view_get_prev(DockView *v, DockViewItem *it);
+void dock_view_move_after(DockView *v, DockViewItem *it, DockViewItem *prev);
+
+// Per-item state; each only redraws, and only if the value changed.
+void dock_view_set_dot(DockView *v, DockViewItem *it, double opacity);
+void dock_view_set_focused(DockView *v, DockViewItem *it, gboolean focused);
+void dock_view_set_separator_before(DockView *v, DockViewItem *it, gboolean sep);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <glib.h>
+
+// Lock-free single-producer/single-consumer queue of socket2 events, from the
+// event thread to the main loop. Slots are preallocated, so pushing never
+// allocates; a full queue drops the line and raises the overflow flag, which
+// the consumer answers with a full resync.
+#define EVENT_QUEUE_SLOTS 1024   // must be a power of two; ~10 ms of events at 100k/s
+#define EVENT_LINE_MAX    512    // longer data is truncated (titles only)
+
+typedef struct {
+    guint bits;                  // HYPR_DIRTY_* classification
+    guint kind;                  // WinEvent, classified by the producer
+    guint len;
+    gint64 time_us;              // monotonic time the line was read
+    char data[EVENT_LINE_MAX];   // what followed "NAME>>", NUL-terminated
+} EventSlot;
+
+typedef struct {
+    EventSlot slots[EVENT_QUEUE_SLOTS];
+    gint head;          // atomic; next slot to pop, written by the consumer only
+    gint tail;          // atomic; next slot to fill, written by the producer only
+    gint overflowed;    // atomic
+} EventQueue;
+
+EventQueue *event_queue_new(void);
+void event_queue_free(EventQueue *q);
+
+// Producer side.
+gboolean event_queue_push(EventQueue *q, guint bits, guint kind, gint64 time_us,
+                          const char *data, gsize len);
+
+// Consumer side: oldest slot or NULL if empty; release it with event_queue_pop().
+const EventSlot *event_queue_peek(EventQueue *q);
+void event_queue_pop(EventQueue *q);
+
+// Returns and clears the overflow flag.
+gboolean event_queue_take_overflow(EventQueue *q);
+
+#endif
@@ -3,6 +3,45 @@
 
 #include <glib-2.0/glib.h>
 
-GHashTable* hypr_get_running_class_counts(void);
+typedef struct {
+    guint64 address;    // window address (hex in Hyprland's replies/events)
+    const char *cls;    // lowercased, stripped "class" (interned)
+    char *title;
+    char *workspace;    // workspace name
+    int workspace_id;
+    int monitor;        // monitor id, -1 if unknown
+    int focus_history;  // focusHistoryID: 0 = most recently focused
+} HyprClient;
+
+typedef struct {
+    int id;
+    char *name;
+    int monitor;        // monitorID, -1 if unknown
+} HyprWorkspace;
+
+typedef struct {
+    int id;
+    char *name;         // connector, e.g. "DP-1"
+    gboolean focused;
+} HyprMonitor;
+
+void hypr_client_free(gpointer p);
+void hypr_workspace_free(gpointer p);
+void hypr_monitor_free(gpointer p);
+
+// Fetches the full client list over the request socket.
+// Returns a GPtrArray of HyprClient* (owns its elements); empty on failure.
+GPtrArray* hypr_get_clients(void);
+
+// Same, from an already fetched j/clients reply.
+GPtrArray* hypr_parse_clients(const char *json, gsize len);
+
+// Parsers for j/workspaces, j/monitors and j/activewindow replies.
+GPtrArray* hypr_parse_workspaces(const char *json, gsize len);  // HyprWorkspace*
+GPtrArray* hypr_parse_monitors(const char *json, gsize len);    // HyprMonitor*
+guint64 hypr_parse_active_address(const char *json, gsize len); // 0 if none
+
+// Focuses a window by address ("dispatch focuswindow" over the request socket).
+gboolean hypr_focus_window(guint64 address);
 
 #endif
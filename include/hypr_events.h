@@ -3,8 +3,21 @@
 
 #include "state.h"
 
+// What a socket2 event can invalidate. Events mapping to none of the bits
+// the main loop currently consumes are dropped in the event thread.
+enum {
+    HYPR_DIRTY_RUNNING   = 1 << 0,  // set of open windows / per-class counts
+    HYPR_DIRTY_ACTIVE    = 1 << 1,  // focused window
+    HYPR_DIRTY_WORKSPACE = 1 << 2,  // window<->workspace placement, workspaces
+    HYPR_DIRTY_MONITOR   = 1 << 3,  // workspace<->monitor placement, monitors
+    HYPR_DIRTY_TITLE     = 1 << 4,  // window titles
+};
+
 // Starts the Hyprland event thread. Safe to call once during app activate.
 void hypr_events_start(AppState *st);
 void hypr_events_stop(AppState *st);
 
+// Logs how many events were acted on versus dropped by classification.
+void hypr_events_log_stats(AppState *st);
+
 #endif
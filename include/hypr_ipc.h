@@ -0,0 +1,20 @@
+#ifndef HYPR_IPC_H
+#define HYPR_IPC_H
+
+#include <glib.h>
+
+// Resolves $XDG_RUNTIME_DIR/hypr/<signature>/<name> for the running instance,
+// e.g. ".socket.sock" (requests) or ".socket2.sock" (events).
+// Caller owns the returned string (free with g_free()); NULL if not found.
+char *hypr_socket_path(const char *name);
+
+// Sends one request over the request socket (e.g. "j/clients") and returns the
+// full reply. Caller owns the returned string; NULL on connection failure or
+// if the whole reply did not arrive within 250 ms.
+char *hypr_ipc_request(const char *req);
+
+// Sends n requests in a single "[[BATCH]]" round trip. Returns a NULL-terminated
+// vector holding one reply per request (free with g_strfreev()), or NULL.
+char **hypr_ipc_batch(const char *const *reqs, guint n);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef ICON_CACHE_H
+#define ICON_CACHE_H
+
+#include <gtk/gtk.h>
+
+// Icon paintables shared by the dock (either renderer, every monitor) and
+// the searcher, keyed by (GIcon, pixel size, scale). Each holds the texture
+// GTK rasterized and uploaded for it, so an icon shown twice, or shown
+// again after the searcher was closed, is not looked up or decoded again.
+//
+// The cache keeps the most recently used entries within a byte budget
+// (texture pixels, 4 bytes each). Entries still shown somewhere are never
+// evicted: dropping them would free nothing. Users are counted explicitly,
+// with acquire/release or by the GtkImage an entry was set on.
+
+#define ICON_CACHE_DEFAULT_BUDGET (32u << 20)
+
+typedef struct _IconCacheEntry IconCacheEntry;
+
+// Never NULL (a missing icon gives the theme's fallback image). Each call
+// needs a matching icon_cache_release().
+IconCacheEntry *icon_cache_acquire(GIcon *gicon, int size, int scale);
+void icon_cache_release(IconCacheEntry *e);
+// Valid until the entry is released.
+GdkPaintable *icon_cache_entry_paintable(IconCacheEntry *e);
+
+// Shows the icon in img, which holds the entry until it is given another
+// one this way or finalized.
+void icon_cache_set_image(GtkImage *img, GIcon *gicon, int size, int scale);
+
+// Largest scale factor of the display's monitors, for widgets that are
+// not on a known monitor yet.
+int icon_cache_display_scale(void);
+
+void icon_cache_set_budget(gsize bytes);
+void icon_cache_log_stats(void);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef ICON_PACK_H
+#define ICON_PACK_H
+
+#include <gtk/gtk.h>
+
+#include "desktop_index.h"
+
+// Application icons already rasterized at the sizes the dock and searcher
+// draw them, saved to $XDG_CACHE_HOME/simple-gui/icons.pack and mmap'ed on
+// the next start, so the first paint skips theme lookups and SVG
+// rendering. Textures are made straight from the mapped pixels.
+//
+// The pack is for one icon theme and is dropped when any of that theme's
+// dirs (its own, those it inherits, and hicolor) or their icon-theme.cache
+// change, which is what installing or removing icons does. It is rebuilt
+// on a worker thread and replaces the mapped one once written.
+
+// Maps the pack if it matches the current theme and is still fresh.
+void icon_pack_load(void);
+
+// Rebuilds the pack in the background unless the mapped one already has
+// every theme icon of apps' entries at each of sizes (n_sizes of them), at
+// each monitor scale.
+void icon_pack_ensure(const DesktopIndex *apps, const int *sizes, guint n_sizes);
+
+// Texture for a theme icon name, or NULL if the pack does not have it.
+GdkTexture *icon_pack_lookup(const char *name, int size, int scale);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <glib.h>
+
+// Process-wide pool of canonical strings for the small, recurring set of
+// desktop ids, match keys and window classes. Equal strings intern to the
+// same pointer, so tables keyed by them can use g_direct_hash and compare
+// with ==. Lookups of strings already in the pool allocate nothing.
+//
+// Strings are never freed: the set is bounded by the installed apps and
+// the classes seen in one session. Safe to call from any thread.
+
+// s as is (desktop ids are case-sensitive). NULL stays NULL.
+const char *intern(const char *s);
+
+// s lowercased (ASCII, like g_ascii_strdown()), for match keys and
+// classes. The _len form takes n bytes of s, which need not end in a NUL.
+const char *intern_lower(const char *s);
+const char *intern_lower_len(const char *s, gsize n);
+
+typedef struct {
+    guint strings;
+    gsize text_bytes;       // the strings themselves, NULs included
+    gsize table_bytes;      // estimated overhead of the hash table
+    guint64 lookups;
+    guint64 hits;           // lookups that found the string already there
+} InternStats;
+
+void intern_get_stats(InternStats *out);
+void intern_log_stats(void);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <stddef.h>
+
+// Single-pass key extractor for arrays of JSON objects (Hyprland replies).
+// Unlike jsmn this builds no token array: memory use is constant no matter
+// how large the document is. Strings and structural characters are located
+// with SSE2/AVX2 when the CPU has them, with a scalar fallback elsewhere.
+
+#define JSON_SCAN_MAX_PATHS 16
+#define JSON_SCAN_MAX_DEPTH 64
+
+typedef enum {
+    JSON_SCAN_NONE = 0,      // key absent from this object
+    JSON_SCAN_STRING = 1,
+    JSON_SCAN_PRIMITIVE = 2  // number, true, false or null
+} JsonScanType;
+
+typedef struct {
+    const char *ptr;  // points into the document; NOT NUL-terminated
+    size_t len;
+    JsonScanType type;
+    int escaped;      // string contains backslash escapes (see json_unescape)
+} JsonScanValue;
+
+// vals[i] holds the value for paths[i] in the object just closed.
+typedef void (*JsonScanFunc)(const JsonScanValue *vals, void *user);
+
+// Calls cb once per object of a top-level array (or once for a top-level
+// object). paths are keys of that object, or "parent.key" for one level of
+// nesting (e.g. "workspace.id"). Container values are never captured.
+// Returns the number of objects reported, or -1 on malformed input.
+long json_scan_objects(const char *js, size_t len,
+                       const char *const *paths, int npaths,
+                       JsonScanFunc cb, void *user);
+
+// Decodes a string value into out (at least len bytes). Returns bytes written.
+size_t json_unescape(const char *s, size_t len, char *out);
+
+// Integer value of a primitive, or dflt if absent / not a number.
+long long json_scan_int(const JsonScanValue *v, long long dflt);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef LAUNCH_STATS_H
+#define LAUNCH_STATS_H
+
+#include <glib.h>
+
+// Click-to-first-window latency per app. A launch is stamped when the dock
+// or searcher starts an app and closed by the first openwindow event whose
+// class matches the app's desktop_match_key().
+
+#define LAUNCH_HIST_BUCKETS 17          // bucket i: below 2^(i+1) ms (and >= 2^i for i > 0)
+#define LAUNCH_TIMEOUT_US   (120 * G_USEC_PER_SEC)   // fits in the last bucket
+
+typedef struct {
+    guint64 count;
+    guint64 timeouts;       // launches that never produced a window
+    gint64 sum_us, min_us, max_us;
+    guint32 hist[LAUNCH_HIST_BUCKETS];
+    GArray *pending;        // gint64 launch stamps, oldest first
+} LaunchApp;
+
+typedef struct {
+    GHashTable *apps;       // char* match key -> LaunchApp*
+} LaunchStats;
+
+LaunchStats *launch_stats_new(void);
+void launch_stats_free(LaunchStats *ls);
+
+// Call right before starting an app (match_key as from desktop_match_key()).
+void launch_stats_begin(LaunchStats *ls, const char *match_key);
+
+// Feed the data of every openwindow event (what follows "openwindow>>").
+// time_us is when the line was read from the socket (monotonic).
+void launch_stats_note_open(LaunchStats *ls, const char *data, gint64 time_us);
+
+// Logs per-app histograms (SIGHUP).
+void launch_stats_dump(LaunchStats *ls);
+
+#endif
@@ -2,7 +2,9 @@
 #define LAUNCHER_H
 
 #include <gtk/gtk.h>
+#include "desktop_index.h"
 
-void on_app_clicked(GtkButton *b, gpointer user_data);
+// FALSE if nothing was started (the reason is logged).
+gboolean launcher_launch(DesktopIndex *apps, const char *desktop_id);
 
 #endif
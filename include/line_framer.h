@@ -0,0 +1,32 @@
+#ifndef LINE_FRAMER_H
+#define LINE_FRAMER_H
+
+#include <glib.h>
+
+// Fixed-size ring that splits a byte stream into '\n'-terminated lines.
+// Bytes are never shifted: positions are monotonic and masked into the ring,
+// and each byte is scanned for a newline exactly once.
+#define LINE_FRAMER_SIZE 65536   // must be a power of two
+
+typedef struct {
+    char buf[LINE_FRAMER_SIZE];
+    gsize head;         // first unconsumed byte
+    gsize tail;         // end of written data
+    gsize scanned;      // [head, scanned) is known to hold no newline
+    gboolean discarding;    // dropping a line longer than the ring
+    char joined[LINE_FRAMER_SIZE];  // a line that wraps the ring end is copied here
+} LineFramer;
+
+LineFramer *line_framer_new(void);
+void line_framer_free(LineFramer *f);
+void line_framer_reset(LineFramer *f);
+
+// Contiguous free space to read() into; commit what was actually written.
+char *line_framer_reserve(LineFramer *f, gsize *avail);
+void line_framer_commit(LineFramer *f, gsize n);
+
+// Next complete line without its '\n'. The slice stays valid until the
+// next reserve/commit. Returns FALSE when no complete line is buffered.
+gboolean line_framer_next(LineFramer *f, const char **line, gsize *len);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef POLLER_H
+#define POLLER_H
+
+#include "state.h"
+
+// Adaptive polling of the window table's resync batch (clients, workspaces,
+// monitors, active window), used only while the event socket is down.
+// The interval drops to [poll] min_interval_ms after a change and grows by
+// [poll] backoff per unchanged reply, up to max_interval_ms.
+void poller_start(AppState *st);
+void poller_stop(AppState *st);
+
+#endif
@@ -3,7 +3,17 @@
 
 #include "state.h"
 
+typedef enum {
+    SEARCH_MODE_APPS,       // launch a new instance
+    SEARCH_MODE_WINDOWS,    // switch to an open window
+} SearchMode;
+
 void searcher_init(AppState *st);
-void searcher_toggle(AppState *st);
+void searcher_toggle(AppState *st);           // app launcher (SIGUSR1)
+void searcher_toggle_windows(AppState *st);   // window switcher (SIGUSR2)
+
+// Applies desktop index changes (see desktop_index_diff()) to the app
+// list; st->apps is already the new index.
+void searcher_apps_changed(AppState *st, const GArray *changes);
 
 #endif
@@ -2,31 +2,71 @@
 #define STATE_H
 
 #include "config.h"
+#include "wintable.h"
+#include "event_queue.h"
+#include "launch_stats.h"
+#include "desktop_index.h"
 #include "gtk/gtkshortcut.h"
 
 typedef struct {
-  GtkWidget *dock_box;
+	GtkApplication *app;
+	GPtrArray *docks;					// DockSurface* per monitor; NULL where one was removed
+	GListModel *outputs;			// the display's GdkMonitors, watched for hotplug
+	gulong outputs_changed_id;
   GtkCssProvider *css;
 
 	GtkWidget *search_box;
 	GtkWidget *search_entry;
 	GtkWidget *search_flowbox;
+	int search_mode;					// SearchMode currently shown
+	char *search_query;				// lowercased filter text; NULL when empty
+	GPtrArray *search_apps;		// GtkFlowBoxChild* (ref'd) per listed app, index order; NULL until built
 
   DockConfig *cfg;
+	DesktopIndex *apps;				// installed .desktop entries, replaced as they change
+	GHashTable *apps_monitors;	// dir path -> GFileMonitor* for every applications dir
+	GHashTable *apps_dirty;		// dirs with .desktop files changed since the last update
+	guint apps_update_id;			// pending debounced index update
 
   GPtrArray *items;        // DockItem*
+	GHashTable *item_index;		// match_key -> GPtrArray of DockItem* (borrowed from items)
+	const char *focused_key;	// interned match_key shown as focused; NULL if none
+	GPtrArray *running_items;	// DockItem* of running unpinned apps (show_running)
+	GHashTable *running_aliases;	// class -> desktop id of classes whose app already has an entry
+	gboolean running_full_sync;	// next sync looks at every class, not just changed ones
+	guint64 dock_mutations;		// widget property changes made by indicator updates
   guint poll_id;           // polling fallback (if you keep it here)
+	guint poll_interval_ms;	// current adaptive poll interval
+	guint64 poll_hash;			// hash of the last resync batch seen by the poller
 
   gint refresh_pending;    // atomic coalesce flag
   GThread *event_thread;   // optional if you want to track it
 	GPtrArray *monitors; // (GFileMonitor*) free func g_object_unref
 	
-	int event_fd;						// -1 if none
+	int wake_fd;						// eventfd to wake the event thread on stop; -1 if none
+	gint want_polling;			// atomic; event socket down, poll instead
 	gint stop_requested;		// atomic
-	guint refresh_idle_id;	// recommended so stop can cancel it
+	GSource *refresh_source;	// main-thread drain source; the event thread only wakes it
+
+	WinTable *windows;				// open windows, updated from socket2 events
+	EventQueue *events;				// socket2 lines waiting for the main loop (SPSC)
+	gint resync_requested;		// atomic; full client re-query on next refresh
+	guint resync_retry_id;		// pending retry of a failed resync
+	gint events_acted;				// atomic counters from event classification
+	gint events_dropped;
+
+	LaunchStats *launches;		// click-to-first-window latency, dumped on SIGHUP
+
+	guint update_tick_id;			// pending frame-clock indicator update
+	GtkWidget *update_tick_widget;	// the dock widget it is attached to
+	guint update_timer_id;		// pending trailing debounce
+	gint64 update_last_request_us;
+	guint64 update_requests;	// dock_schedule_update() calls
+	guint64 updates_applied;	// indicator passes actually run
+	guint64 updates_merged;		// requests folded into an already pending update
 } AppState;
 
-AppState *app_state_new(GtkWidget *dock_box);
+AppState *app_state_new(GtkApplication *app);
 void app_state_free(AppState *st);
 
 #endif
@@ -3,6 +3,8 @@
 
 #include <gtk4-layer-shell/gtk4-layer-shell.h>
 
+#include "state.h"
+
 void on_config_file_changed(
 		GFileMonitor *mon, 
 		GFile *file, 
@@ -19,4 +21,8 @@ void on_style_file_changed(
 
 void watch_user_file(const char *name, GCallback cb, gpointer user_data);
 
+// Follows every XDG applications dir and applies added, changed and
+// removed entries to st->apps, the dock and the searcher (debounced).
+void watch_application_dirs(AppState *st);
+
 #endif
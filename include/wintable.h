@@ -0,0 +1,127 @@
+#ifndef WINTABLE_H
+#define WINTABLE_H
+
+#include <glib.h>
+
+// Persistent model of Hyprland's windows, workspaces and monitors.
+// Kept current from socket2 events; a full resync is only needed on
+// startup, reconnect, or when an event could not be applied.
+//
+// Windows live in one flat array (swap-remove on close) indexed by address.
+// Classes are interned (intern_lower()) and mapped to small integer ids, so each
+// window carries an id rather than a string and per-class counters
+// (total and per monitor) are plain array slots.
+//
+// Monitors are addressed by dense slot, not by Hyprland's monitor id: ids
+// keep growing across hotplugs, slots are handed out from 0 as monitors
+// appear and reused once a slot is free and empty.
+
+#define WINTABLE_MAX_MONITORS 8   // monitors past this many only count in the total
+
+// socket2 events the table applies. The event thread classifies each line
+// once and queues the kind with the event's data.
+typedef enum {
+    WIN_EVENT_NONE = 0,
+    WIN_EVENT_OPEN_WINDOW,          // openwindow: ADDRESS,WORKSPACENAME,CLASS,TITLE
+    WIN_EVENT_CLOSE_WINDOW,         // closewindow: ADDRESS
+    WIN_EVENT_ACTIVE_WINDOW,        // activewindowv2: ADDRESS
+    WIN_EVENT_MOVE_WINDOW,          // movewindowv2: ADDRESS,WORKSPACEID,WORKSPACENAME
+    WIN_EVENT_WINDOW_TITLE,         // windowtitlev2: ADDRESS,TITLE
+    WIN_EVENT_WINDOW_TITLE_V1,      // windowtitle: ADDRESS (no title; pre-v2 Hyprland)
+    WIN_EVENT_CREATE_WORKSPACE,     // createworkspacev2: ID,NAME
+    WIN_EVENT_DESTROY_WORKSPACE,    // destroyworkspacev2: ID,NAME
+    WIN_EVENT_RENAME_WORKSPACE,     // renameworkspace: ID,NEWNAME
+    WIN_EVENT_MOVE_WORKSPACE,       // moveworkspacev2: ID,NAME,MONNAME
+    WIN_EVENT_FOCUSED_MONITOR,      // focusedmonv2: MONNAME,WORKSPACEID
+    WIN_EVENT_MONITOR_ADDED,        // monitoraddedv2: ID,NAME,DESCRIPTION
+    WIN_EVENT_MONITOR_REMOVED,      // monitorremovedv2: ID,NAME,DESCRIPTION
+} WinEvent;
+
+typedef struct {
+    guint64 address;
+    char *title;
+    guint32 cls;            // class id (index into WinTable.classes)
+    gint32 workspace_id;
+    gint32 monitor;         // monitor slot, -1 if unknown
+    guint32 focus_seq;      // larger = focused more recently
+} WinEntry;
+
+typedef struct {
+    gint32 workspace_id;
+    guint32 count;
+} WinWsCount;
+
+typedef struct {
+    const char *key;        // interned lowercased class
+    guint32 count;
+    guint16 per_mon[WINTABLE_MAX_MONITORS];   // by monitor slot
+    GArray *per_ws;         // WinWsCount for each workspace holding one (NULL until used)
+    GArray *wins;           // guint64 addresses of this class's windows (NULL until used)
+    gboolean changed;       // listed in WinTable.changed
+} ClassEntry;
+
+typedef struct {
+    GArray *wins;           // WinEntry, unordered
+    GHashTable *win_index;  // address -> index + 1
+    GArray *classes;        // ClassEntry, indexed by class id; ids are never reused
+    GArray *changed;        // guint32 ids of classes whose count moved since wintable_clear_changed()
+    GHashTable *class_ids;  // interned class -> id + 1 (pointer keys)
+    GHashTable *ws_by_name; // char* workspace name -> WsInfo*
+    GHashTable *mon_ids;    // char* monitor name -> slot + 1
+    gint32 mon_slot_ids[WINTABLE_MAX_MONITORS];   // Hyprland monitor id per slot, -1 if free
+    guint32 mon_slot_wins[WINTABLE_MAX_MONITORS]; // windows counted in each slot
+    guint64 active;         // focused window address, 0 if none
+    gint32 focused_mon;     // monitor slot
+    guint32 focus_clock;
+    gboolean resync_needed;
+    gboolean titles_v2;     // the compositor sends windowtitlev2
+    gboolean titles_stale;  // a title changed that only a resync can fetch
+} WinTable;
+
+WinTable *wintable_new(void);
+void wintable_free(WinTable *t);
+
+// Replaces the model with the compositor's current clients, workspaces,
+// monitors and active window (one batched round trip). If the compositor
+// can't be reached the table is left as it was, with resync_needed set,
+// and FALSE is returned; the caller retries later.
+gboolean wintable_resync(WinTable *t);
+
+// The requests a resync batches, and applying their replies, for callers
+// that fetch them themselves (the poller hashes them first).
+#define WINTABLE_RESYNC_REQUESTS 4
+extern const char *const wintable_resync_requests[WINTABLE_RESYNC_REQUESTS];
+void wintable_apply_resync(WinTable *t, char **replies);
+
+// Replaces only the windows, from a client list the caller already fetched
+// (takes ownership). Workspace and monitor maps are left as they are.
+void wintable_replace(WinTable *t, GPtrArray *clients);
+
+// Applies one socket2 event: its kind and the data after "NAME>>".
+// Returns TRUE if anything the dock shows changed: per-class counts,
+// per-monitor counts or the focused window's class.
+gboolean wintable_apply_event(WinTable *t, WinEvent kind, const char *data);
+
+// Lookups. Class keys are lowercased Hyprland classes and must come from
+// intern_lower() (dock match keys do): the table compares pointers.
+int wintable_class_count(WinTable *t, const char *cls);
+int wintable_class_count_on(WinTable *t, const char *cls, int slot);
+int wintable_class_count_ws(WinTable *t, const char *cls, int workspace_id);
+const char *wintable_active_class(WinTable *t);   // NULL if nothing is focused
+int wintable_monitor_slot(WinTable *t, const char *name);   // -1 if unknown or unslotted
+const char *wintable_class_key(WinTable *t, guint32 id);  // class of WinEntry.cls
+
+// Window of class cls a dock click should focus, or 0 if it has none.
+// If a window of that class already has focus this is the class's least
+// recently focused window, so repeated clicks cycle through all of them;
+// otherwise it is the most recently focused one.
+guint64 wintable_pick_window(WinTable *t, const char *cls);
+
+// Empties WinTable.changed once the caller has looked at it.
+void wintable_clear_changed(WinTable *t);
+
+// Records a focus change we caused ourselves, ahead of the compositor's
+// activewindowv2 event, so quick repeated clicks keep cycling.
+void wintable_mark_focused(WinTable *t, guint64 address);
+
+#endif
@@ -9,8 +9,10 @@
 #include "state.h"
 #include "dock.h"
 #include "hypr_events.h"
-#include "watch.h" // watch_user_file, on_style_file_changed, on_config_file_changed
+#include "watch.h" // watch_user_file, watch_application_dirs, on_*_file_changed
 #include "searcher.h"
+#include "intern.h"
+#include "icon_cache.h"
 
 /* App Searcher */
 
@@ -20,81 +22,81 @@ static gboolean on_sigusr1(gpointer user_data) {
 	return G_SOURCE_CONTINUE;
 }
 
-/* App Dock */
-
-static void force_window_full_width(GtkWindow *win) {
-    GdkDisplay *dpy = gdk_display_get_default();
-    if (!dpy) return;
+static gboolean on_sigusr2(gpointer user_data) {
+	AppState *st = (AppState *)user_data;
+	searcher_toggle_windows(st);
+	return G_SOURCE_CONTINUE;
+}
 
-    GListModel *mons = gdk_display_get_monitors(dpy);
-    if (!mons || g_list_model_get_n_items(mons) == 0) return;
+static gboolean on_sighup(gpointer user_data) {
+	AppState *st = (AppState *)user_data;
+	launch_stats_dump(st->launches);
+	intern_log_stats();
+	icon_cache_log_stats();
+	return G_SOURCE_CONTINUE;
+}
 
-    GdkMonitor *mon = GDK_MONITOR(g_list_model_get_item(mons, 0)); // ref
-    if (!mon) return;
+/* App Dock */
 
-    GdkRectangle geo;
-    gdk_monitor_get_geometry(mon, &geo);
-    gtk_window_set_default_size(win, geo.width, 1); // full width, minimal height
-    g_object_unref(mon);
+static void on_shutdown(GApplication *app, gpointer user_data) {
+    (void)user_data;
+    // Frees the state while the dock windows still exist.
+    g_object_set_data(G_OBJECT(app), "app-state", NULL);
 }
 
 static void on_activate(GtkApplication *app, gpointer user_data) {
     (void)user_data;
 
-    // Window
-    GtkWidget *win = gtk_application_window_new(app);
-    gtk_window_set_decorated(GTK_WINDOW(win), FALSE);
-    gtk_window_set_resizable(GTK_WINDOW(win), FALSE);
-
-    // Layer shell (GTK4)
-    gtk_layer_init_for_window(GTK_WINDOW(win));
-    gtk_layer_set_layer(GTK_WINDOW(win), GTK_LAYER_SHELL_LAYER_TOP);
-    gtk_layer_set_anchor(GTK_WINDOW(win), GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
-    gtk_layer_set_anchor(GTK_WINDOW(win), GTK_LAYER_SHELL_EDGE_LEFT, TRUE);
-    gtk_layer_set_anchor(GTK_WINDOW(win), GTK_LAYER_SHELL_EDGE_RIGHT, TRUE);
-    gtk_layer_auto_exclusive_zone_enable(GTK_WINDOW(win));
-    force_window_full_width(GTK_WINDOW(win));
+    // Already running: a second launch only re-activates.
+    if (g_object_get_data(G_OBJECT(app), "app-state")) return;
 
-    gtk_widget_add_css_class(win, "dock-window");
-
-    // Full-width parent with centered dock
-    GtkWidget *outer = gtk_center_box_new();
-    gtk_widget_set_hexpand(outer, TRUE);
-    gtk_widget_set_halign(outer, GTK_ALIGN_FILL);
-
-    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
-    gtk_widget_add_css_class(box, "dock");
-    gtk_widget_set_halign(box, GTK_ALIGN_CENTER);
-
-    gtk_center_box_set_center_widget(GTK_CENTER_BOX(outer), box);
-    gtk_window_set_child(GTK_WINDOW(win), outer);
-
-    // Create state and attach it to the window for automatic cleanup
-    AppState *st = app_state_new(box);
+    // State lives as long as the app, not any one dock window: docks come
+    // and go with monitors, and with none plugged in there are no windows.
+    gint64 t0 = g_get_monotonic_time();
+    AppState *st = app_state_new(app);
+    gint64 t_state = g_get_monotonic_time();
     g_object_set_data_full(
-        G_OBJECT(win),
+        G_OBJECT(app),
         "app-state",
         st,
         (GDestroyNotify)app_state_free
     );
+    g_application_hold(G_APPLICATION(app));
 
-    // Build dock UI from current config/state
+    // One dock per monitor from current config/state
     dock_init(st);
+    gint64 t_dock = g_get_monotonic_time();
 		
 		// Initialize searcher
 		searcher_init(st);
+		gint64 t_searcher = g_get_monotonic_time();
+
+		// Startup cost, to compare a warm desktop index cache with a cold one
+		g_message("Startup: state %.1f ms (%s desktop index), docks %.1f ms, searcher %.1f ms",
+		          (t_state - t0) / 1000.0, desktop_index_source_name(st->apps->source),
+		          (t_dock - t_state) / 1000.0, (t_searcher - t_dock) / 1000.0);
+
+		// Rasterize what was just drawn from the theme, for the next start
+		dock_update_icon_pack(st);
 
 		// Listen for SIGUSR1 to toggle searcher
 		g_unix_signal_add(SIGUSR1, on_sigusr1, st);
 
+		// ... and SIGUSR2 to toggle it as a window switcher
+		g_unix_signal_add(SIGUSR2, on_sigusr2, st);
+
+		// SIGHUP logs launch latency histograms, string pool and icon cache stats
+		g_unix_signal_add(SIGHUP, on_sighup, st);
+
     // Live reload (these should be updated to accept/pass st as user_data)
     watch_user_file("style.css",  G_CALLBACK(on_style_file_changed),  st);
     watch_user_file("config.ini", G_CALLBACK(on_config_file_changed), st);
 
+    // Installed and removed apps reach the dock and searcher as deltas
+    watch_application_dirs(st);
+
     // Events (thread / fallback polling should schedule refreshes using st)
     hypr_events_start(st);
-
-    gtk_window_present(GTK_WINDOW(win));
 }
 
 GtkApplication *app_new(void) {
@@ -102,5 +104,6 @@ GtkApplication *app_new(void) {
         gtk_application_new("com.app.dock.hyprland", G_APPLICATION_DEFAULT_FLAGS);
 
     g_signal_connect(app, "activate", G_CALLBACK(on_activate), NULL);
+    g_signal_connect(app, "shutdown", G_CALLBACK(on_shutdown), NULL);
     return app;
 }
@@ -1,4 +1,5 @@
 #include "config.h"
+#include "icon_cache.h"
 
 static gchar** split_csv_trim(const gchar *s) {
 	if (!s || !*s) return NULL;
@@ -45,6 +46,15 @@ DockConfig* dock_config_load(void) {
 	DockConfig *cfg = g_new0(DockConfig, 1);
 	cfg->icon_size = 32;
 	cfg->searcher_icon_size = 64;
+	cfg->refresh_debounce_ms = 0;
+	cfg->click_action = DOCK_CLICK_LAUNCH;
+	cfg->show_running = FALSE;
+	cfg->renderer = DOCK_RENDER_WIDGETS;
+	cfg->magnify = 1.0;
+	cfg->icon_cache_bytes = ICON_CACHE_DEFAULT_BUDGET;
+	cfg->poll_min_ms = 250;
+	cfg->poll_max_ms = 5000;
+	cfg->poll_backoff = 2.0;
 
 	GKeyFile *kf = g_key_file_new();
 	gchar *path = dock_find_config_path("config.ini");
@@ -60,13 +70,60 @@ DockConfig* dock_config_load(void) {
 	GError *err = NULL;
 	int icon_size = g_key_file_get_integer(kf, "dock", "icon_size", &err);
 	if (!err && icon_size > 0 && icon_size <= 256) cfg->icon_size = icon_size;
-	if (err) g_error_free(err);
+	g_clear_error(&err);
+
+	int debounce = g_key_file_get_integer(kf, "dock", "refresh_debounce_ms", &err);
+	if (!err && debounce >= 0 && debounce <= 1000) cfg->refresh_debounce_ms = debounce;
+	g_clear_error(&err);
+
+	gchar *click = g_key_file_get_string(kf, "dock", "click_action", NULL);
+	if (click) {
+		g_strstrip(click);
+		if (g_ascii_strcasecmp(click, "focus") == 0) cfg->click_action = DOCK_CLICK_FOCUS;
+		else if (g_ascii_strcasecmp(click, "launch") != 0) g_warning("Unknown click_action '%s', using launch", click);
+		g_free(click);
+	}
+
+	gchar *renderer = g_key_file_get_string(kf, "dock", "renderer", NULL);
+	if (renderer) {
+		g_strstrip(renderer);
+		if (g_ascii_strcasecmp(renderer, "snapshot") == 0) cfg->renderer = DOCK_RENDER_SNAPSHOT;
+		else if (g_ascii_strcasecmp(renderer, "widgets") != 0) g_warning("Unknown renderer '%s', using widgets", renderer);
+		g_free(renderer);
+	}
+
+	// Capped again at draw time to the headroom style.css gives the dock
+	double magnify = g_key_file_get_double(kf, "dock", "magnify", &err);
+	if (!err && magnify >= 1.0 && magnify <= 2.0) cfg->magnify = magnify;
+	g_clear_error(&err);
+
+	gboolean running = g_key_file_get_boolean(kf, "dock", "show_running", &err);
+	if (!err) cfg->show_running = running;
+	g_clear_error(&err);
+
+	int budget_kb = g_key_file_get_integer(kf, "icons", "cache_budget_kb", &err);
+	if (!err && budget_kb >= 0 && budget_kb <= 1024 * 1024) cfg->icon_cache_bytes = (gsize)budget_kb << 10;
+	g_clear_error(&err);
 
 	int s_size = g_key_file_get_integer(kf, "searcher", "icon_size", &err);
 	if (!err && s_size > 0 && s_size <= 512) {
 		cfg->searcher_icon_size = s_size;
 	}
-	if (err) g_error_free(err);
+	g_clear_error(&err);
+
+	int p_min = g_key_file_get_integer(kf, "poll", "min_interval_ms", &err);
+	if (!err && p_min >= 50 && p_min <= 60000) cfg->poll_min_ms = p_min;
+	g_clear_error(&err);
+
+	int p_max = g_key_file_get_integer(kf, "poll", "max_interval_ms", &err);
+	if (!err && p_max >= 50 && p_max <= 600000) cfg->poll_max_ms = p_max;
+	g_clear_error(&err);
+
+	if (cfg->poll_max_ms < cfg->poll_min_ms) cfg->poll_max_ms = cfg->poll_min_ms;
+
+	double p_backoff = g_key_file_get_double(kf, "poll", "backoff", &err);
+	if (!err && p_backoff >= 1.0 && p_backoff <= 10.0) cfg->poll_backoff = p_backoff;
+	g_clear_error(&err);
 
 	gchar *apps = g_key_file_get_string(kf, "pinned", "apps", NULL);
 	cfg->pinned_apps = split_csv_trim(apps);
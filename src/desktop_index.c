@@ -0,0 +1,815 @@
+#include "desktop_index.h"
+#include "desktop_match.h"
+#include "desktop_parse.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio-unix-2.0/gio/gdesktopappinfo.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/* On-disk cache */
+
+// Native byte order and alignment: the file is only ever read back on the
+// machine that wrote it. Bump the version when the layout or the meaning
+// of a field changes.
+#define CACHE_MAGIC      "SGDIDX\n"     // 8 bytes with the NUL
+#define CACHE_VERSION    3
+#define CACHE_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[8];
+    guint32 version;
+    guint32 byte_order;
+    guint32 n_fields;       // DESKTOP_N_FIELDS
+    guint32 n_entries;
+    guint32 n_dirs;
+    guint32 n_exec_dirs;
+    guint32 context;        // string: locale, desktop, PATH and dir list it was built for
+    guint32 strings_len;
+    guint32 dirs_off;       // file offsets of the sections below
+    guint32 exec_dirs_off;
+    guint32 cols_off;
+    guint32 flags_off;
+    guint32 strings_off;
+    guint32 reserved;
+} CacheHeader;
+
+// Every dir scanned, top-level ones first in their own scan order. The
+// files directly in a dir are entries [first, first + count).
+typedef struct {
+    guint32 path;           // string
+    guint32 prefix;         // desktop id prefix of its files, "" at the top
+    guint32 parent;         // index + 1 of the dir it is in, 0 at the top
+    guint32 first;
+    guint32 count;
+    guint32 reserved;
+    gint64 mtime_ns;        // -1 if it did not exist
+} CacheDir;
+
+// Where the TryExec programs of the entries were looked for: their dir for
+// an absolute path, every $PATH dir otherwise. Installing or removing one
+// changes its dir's mtime, and then TryExec is checked again.
+typedef struct {
+    guint32 path;           // string
+    guint32 reserved;
+    gint64 mtime_ns;        // -1 if it did not exist
+} CacheExecDir;
+
+typedef struct {
+    GMappedFile *map;
+    const CacheHeader *h;
+    const CacheDir *dirs;
+    const CacheExecDir *exec_dirs;
+    const guint32 *cols[DESKTOP_N_FIELDS];
+    const guint8 *flags;
+    const char *strings;
+} Cache;
+
+static char *cache_path(void) {
+    return g_build_filename(g_get_user_cache_dir(), "simple-gui", "desktop-index.bin", NULL);
+}
+
+// Maps the cache and checks that every offset in it stays in bounds, so
+// the columns can be used without further checks.
+static gboolean cache_open(Cache *c, const char *path) {
+    memset(c, 0, sizeof *c);
+    GMappedFile *map = g_mapped_file_new(path, FALSE, NULL);
+    if (!map) return FALSE;
+
+    gsize size = g_mapped_file_get_length(map);
+    const char *base = g_mapped_file_get_contents(map);
+    const CacheHeader *h = (const CacheHeader *)base;
+
+    if (size < sizeof *h || memcmp(h->magic, CACHE_MAGIC, sizeof h->magic) != 0
+        || h->version != CACHE_VERSION || h->byte_order != CACHE_BYTE_ORDER
+        || h->n_fields != DESKTOP_N_FIELDS) goto bad;
+
+    guint64 n = h->n_entries;
+    if (h->dirs_off % 8 || h->cols_off % 4
+        || h->dirs_off + (guint64)h->n_dirs * sizeof(CacheDir) > size
+        || h->exec_dirs_off % 8
+        || h->exec_dirs_off + (guint64)h->n_exec_dirs * sizeof(CacheExecDir) > size
+        || h->cols_off + n * sizeof(guint32) * DESKTOP_N_FIELDS > size
+        || h->flags_off + n > size
+        || h->strings_len == 0 || h->strings_off + (guint64)h->strings_len > size
+        || base[h->strings_off + h->strings_len - 1] != '\0'
+        || h->context >= h->strings_len) goto bad;
+
+    c->h = h;
+    c->dirs = (const CacheDir *)(base + h->dirs_off);
+    c->exec_dirs = (const CacheExecDir *)(base + h->exec_dirs_off);
+    for (guint f = 0; f < DESKTOP_N_FIELDS; f++) {
+        c->cols[f] = (const guint32 *)(base + h->cols_off) + (gsize)f * n;
+        for (guint i = 0; i < n; i++) {
+            if (c->cols[f][i] >= h->strings_len) goto bad;
+        }
+    }
+    c->flags = (const guint8 *)(base + h->flags_off);
+    c->strings = base + h->strings_off;
+
+    for (guint d = 0; d < h->n_dirs; d++) {
+        const CacheDir *cd = &c->dirs[d];
+        if (cd->path >= h->strings_len || cd->prefix >= h->strings_len || cd->parent > h->n_dirs
+            || (guint64)cd->first + cd->count > n) goto bad;
+    }
+    for (guint d = 0; d < h->n_exec_dirs; d++) {
+        if (c->exec_dirs[d].path >= h->strings_len) goto bad;
+    }
+
+    c->map = map;
+    return TRUE;
+
+bad:
+    g_debug("desktop index: ignoring invalid cache %s", path);
+    g_mapped_file_unref(map);
+    memset(c, 0, sizeof *c);
+    return FALSE;
+}
+
+static gint64 dir_mtime(const char *dir) {
+    struct stat sb;
+    if (stat(dir, &sb) != 0 || !S_ISDIR(sb.st_mode)) return -1;
+    return (gint64)sb.st_mtim.tv_sec * G_GINT64_CONSTANT(1000000000) + sb.st_mtim.tv_nsec;
+}
+
+// Adding, removing or renaming an entry (which is how packages and most
+// editors replace files) changes its dir's mtime.
+static gboolean cache_fresh(const Cache *c) {
+    for (guint d = 0; d < c->h->n_dirs; d++) {
+        if (dir_mtime(c->strings + c->dirs[d].path) != c->dirs[d].mtime_ns) return FALSE;
+    }
+    return TRUE;
+}
+
+// Whether every TryExec result in the cache would come out the same.
+static gboolean cache_exec_fresh(const Cache *c) {
+    for (guint d = 0; d < c->h->n_exec_dirs; d++) {
+        if (dir_mtime(c->strings + c->exec_dirs[d].path) != c->exec_dirs[d].mtime_ns) return FALSE;
+    }
+    return TRUE;
+}
+
+static int cache_find_dir(const Cache *c, const char *path) {
+    for (guint d = 0; c && d < c->h->n_dirs; d++) {
+        if (strcmp(c->strings + c->dirs[d].path, path) == 0) return (int)d;
+    }
+    return -1;
+}
+
+/* Building */
+
+// Below this many files per thread, starting threads costs more than it saves.
+#define PARSE_MAX_THREADS  8
+#define PARSE_MIN_PER_THREAD  64
+
+// A file to parse. Workers fill in vals and flags; the entry is appended
+// later, in scan order, so the index does not depend on thread timing.
+typedef struct {
+    char *path;
+    char *id;
+    char *vals[DESKTOP_N_FIELDS];   // owned; NULL means ""
+    guint8 flags;
+} ParseJob;
+
+// One per entry, in index order: a file parsed this time or an entry of
+// the old cache.
+typedef struct {
+    ParseJob *job;          // NULL: take entry `cached` of the old cache
+    guint cached;
+} Slot;
+
+typedef struct {
+    DesktopIndex *idx;
+    GHashTable *interned;   // char* -> offset (build time only: strings may move)
+    GHashTable *seen;       // desktop ids already claimed by an earlier dir
+    char **desktops;        // $XDG_CURRENT_DESKTOP, split
+    const char *const *langs;   // g_get_language_names() of the main thread
+    const Cache *old;       // previous cache to take unchanged dirs from, or NULL
+    GHashTable *dirty;      // dirs to read again even if their mtime did not change
+    gboolean exec_stale;    // old TryExec results may be wrong: parse those entries again
+    GArray *dirs;           // CacheDir for the cache written afterwards
+    GArray *slots;          // Slot
+    GPtrArray *jobs;        // ParseJob*, the files to parse
+    gint next_job;          // claimed by the workers with an atomic add
+} Builder;
+
+static void parse_job_free(ParseJob *j) {
+    g_free(j->path);
+    g_free(j->id);
+    for (guint f = 0; f < DESKTOP_N_FIELDS; f++) g_free(j->vals[f]);
+    g_free(j);
+}
+
+static guint32 blob_intern(Builder *b, const char *s) {
+    if (!s || !*s) return 0;
+
+    gpointer off;
+    if (g_hash_table_lookup_extended(b->interned, s, NULL, &off)) return GPOINTER_TO_UINT(off);
+
+    guint32 o = (guint32)b->idx->own_strings->len;
+    g_string_append_len(b->idx->own_strings, s, (gssize)strlen(s) + 1);
+    g_hash_table_insert(b->interned, g_strdup(s), GUINT_TO_POINTER(o));
+    return o;
+}
+
+static void append_entry(Builder *b, const char *const *vals, guint8 flags) {
+    DesktopIndex *idx = b->idx;
+
+    // The first dir to provide an id owns it, even if its entry is masked.
+    const char *id = vals[DESKTOP_FIELD_ID];
+    if (g_hash_table_contains(b->seen, id)) flags |= DESKTOP_ENTRY_SHADOWED;
+    else g_hash_table_add(b->seen, g_strdup(id));
+
+    for (guint f = 0; f < DESKTOP_N_FIELDS; f++) {
+        guint32 off = blob_intern(b, vals[f]);
+        g_array_append_val(idx->own_cols[f], off);
+    }
+    g_array_append_val(idx->own_flags, flags);
+    idx->n++;
+}
+
+// Shadowing is worked out again: the dir that shadowed it may have changed.
+static void copy_entry(Builder *b, guint e) {
+    const Cache *c = b->old;
+    const char *vals[DESKTOP_N_FIELDS];
+    for (guint f = 0; f < DESKTOP_N_FIELDS; f++) vals[f] = c->strings + c->cols[f][e];
+    append_entry(b, vals, c->flags[e] & ~DESKTOP_ENTRY_SHADOWED);
+}
+
+// Same visibility rules as g_app_info_should_show().
+static gboolean should_show(const Builder *b, const DesktopEntry *e) {
+    if (e->no_display) return FALSE;
+
+    gboolean show = TRUE;
+    if (e->only_show_in) show = desktop_list_contains_any(e->only_show_in, b->desktops);
+    if (desktop_list_contains_any(e->not_show_in, b->desktops)) show = FALSE;
+    return show;
+}
+
+static gboolean try_exec_ok(const char *try_exec) {
+    if (!try_exec || !*try_exec) return TRUE;
+    char *found = g_find_program_in_path(try_exec);
+    gboolean ok = found != NULL;
+    g_free(found);
+    return ok;
+}
+
+// Runs on a worker thread: reads only the file and b's read-only fields.
+// Shadowed entries are parsed too: if the dir shadowing them changes,
+// they come back from the cache without their own dir being read again.
+static void parse_job(const Builder *b, ParseJob *j) {
+    DesktopEntry e;
+    if (!desktop_entry_parse(j->path, b->langs, &e)) {
+        j->flags = DESKTOP_ENTRY_MASKED;
+        return;
+    }
+    j->vals[DESKTOP_FIELD_TRY_EXEC] = g_strdup(e.try_exec);
+    if (g_strcmp0(e.type, "Application") != 0 || e.hidden || !try_exec_ok(e.try_exec)) {
+        desktop_entry_clear(&e);
+        j->flags = DESKTOP_ENTRY_MASKED;
+        return;
+    }
+
+    char *joined = g_strjoin("\n", e.name ? e.name : "", e.generic_name ? e.generic_name : "",
+                             e.keywords ? e.keywords : "", j->id, NULL);
+    j->vals[DESKTOP_FIELD_SEARCH_KEY] = g_ascii_strdown(joined, -1);
+    g_free(joined);
+    j->vals[DESKTOP_FIELD_MATCH_KEY] = desktop_match_key_from(e.wm_class, j->id);
+
+    j->vals[DESKTOP_FIELD_NAME]         = e.name ? g_steal_pointer(&e.name) : g_strdup(j->id);
+    j->vals[DESKTOP_FIELD_GENERIC_NAME] = g_steal_pointer(&e.generic_name);
+    j->vals[DESKTOP_FIELD_KEYWORDS]     = g_steal_pointer(&e.keywords);
+    j->vals[DESKTOP_FIELD_ICON]         = g_steal_pointer(&e.icon);
+    j->vals[DESKTOP_FIELD_EXEC]         = g_steal_pointer(&e.exec);
+    j->vals[DESKTOP_FIELD_WORKDIR]      = g_steal_pointer(&e.workdir);
+    j->vals[DESKTOP_FIELD_WM_CLASS]     = g_steal_pointer(&e.wm_class);
+    j->vals[DESKTOP_FIELD_ACTIONS]      = g_steal_pointer(&e.actions);
+
+    j->flags = 0;
+    if (e.terminal) j->flags |= DESKTOP_ENTRY_TERMINAL;
+    if (should_show(b, &e)) j->flags |= DESKTOP_ENTRY_SHOW;
+    desktop_entry_clear(&e);
+}
+
+static gpointer parse_worker(gpointer data) {
+    Builder *b = data;
+    for (;;) {
+        guint i = (guint)g_atomic_int_add(&b->next_job, 1);
+        if (i >= b->jobs->len) break;
+        parse_job(b, g_ptr_array_index(b->jobs, i));
+    }
+    return NULL;
+}
+
+// Files are handed out one at a time, so a few large ones do not leave
+// the other threads idle. The calling thread is one of the workers.
+static void parse_all(Builder *b) {
+    guint n = b->jobs->len;
+    if (n == 0) return;
+
+    gint64 t0 = g_get_monotonic_time();
+    guint threads = CLAMP(g_get_num_processors(), 1, PARSE_MAX_THREADS);
+    threads = MIN(threads, (n + PARSE_MIN_PER_THREAD - 1) / PARSE_MIN_PER_THREAD);
+
+    GThread *workers[PARSE_MAX_THREADS];
+    for (guint t = 1; t < threads; t++) workers[t] = g_thread_new("desktop-parse", parse_worker, b);
+    parse_worker(b);
+    for (guint t = 1; t < threads; t++) g_thread_join(workers[t]);
+
+    g_debug("desktop index: parsed %u files on %u threads in %.1f ms",
+            n, threads, (g_get_monotonic_time() - t0) / 1000.0);
+}
+
+// Single-threaded, in slot order: interning and shadowing come out the
+// same on every run.
+static void merge_slots(Builder *b) {
+    for (guint i = 0; i < b->slots->len; i++) {
+        const Slot *s = &g_array_index(b->slots, Slot, i);
+        if (!s->job) {
+            copy_entry(b, s->cached);
+            continue;
+        }
+        const char *vals[DESKTOP_N_FIELDS];
+        for (guint f = 0; f < DESKTOP_N_FIELDS; f++) vals[f] = s->job->vals[f];
+        vals[DESKTOP_FIELD_ID] = s->job->id;
+        vals[DESKTOP_FIELD_FILE] = s->job->path;
+        append_entry(b, vals, s->job->flags);
+    }
+}
+
+static gint cmp_names(gconstpointer a, gconstpointer b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Desktop ids are paths below applications/ with '/' turned into '-'.
+// A dir whose mtime matches the old cache (and that is not dirty) is taken
+// from it as is, down to its subdirs (each checked the same way); anything
+// else is listed again and its files queued for parse_all().
+static void scan_dir(Builder *b, const char *dir, const char *prefix, guint32 parent) {
+    gint64 mtime = dir_mtime(dir);
+    CacheDir rec = {
+        .path = blob_intern(b, dir),
+        .prefix = blob_intern(b, prefix),
+        .parent = parent,
+        .first = b->slots->len,
+        .mtime_ns = mtime,
+    };
+    guint self = b->dirs->len;
+    g_array_append_val(b->dirs, rec);
+
+    int old = cache_find_dir(b->old, dir);
+    gboolean dirty = b->dirty && g_hash_table_contains(b->dirty, dir);
+    if (old >= 0 && b->old->dirs[old].mtime_ns == mtime && !dirty) {
+        const CacheDir *cd = &b->old->dirs[old];
+        for (guint e = cd->first; e < cd->first + cd->count; e++) {
+            Slot s = { .job = NULL, .cached = e };
+            const char *try_exec = b->old->strings + b->old->cols[DESKTOP_FIELD_TRY_EXEC][e];
+            if (b->exec_stale && *try_exec) {
+                s.job = g_new0(ParseJob, 1);
+                s.job->path = g_strdup(b->old->strings + b->old->cols[DESKTOP_FIELD_FILE][e]);
+                s.job->id = g_strdup(b->old->strings + b->old->cols[DESKTOP_FIELD_ID][e]);
+                g_ptr_array_add(b->jobs, s.job);
+            }
+            g_array_append_val(b->slots, s);
+        }
+        g_array_index(b->dirs, CacheDir, self).count = b->slots->len - rec.first;
+
+        for (guint d = 0; d < b->old->h->n_dirs; d++) {
+            const CacheDir *sub = &b->old->dirs[d];
+            if (sub->parent != (guint32)old + 1) continue;
+            scan_dir(b, b->old->strings + sub->path, b->old->strings + sub->prefix, self + 1);
+        }
+        return;
+    }
+    if (mtime < 0) return;  // recorded anyway, so creating it later is noticed
+
+    GDir *d = g_dir_open(dir, 0, NULL);
+    if (!d) return;
+    b->idx->dirs_read++;
+
+    // Sorted, so the index (and its order) is the same from run to run.
+    GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
+    const char *name;
+    while ((name = g_dir_read_name(d))) g_ptr_array_add(names, g_strdup(name));
+    g_dir_close(d);
+    g_ptr_array_sort(names, cmp_names);
+
+    // Files first, so this dir's entries form one range; subdirs after.
+    GPtrArray *subdirs = g_ptr_array_new_with_free_func(g_free);
+    for (guint i = 0; i < names->len; i++) {
+        const char *n = g_ptr_array_index(names, i);
+        char *path = g_build_filename(dir, n, NULL);
+
+        if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+            g_ptr_array_add(subdirs, path);
+            continue;
+        }
+        if (!g_str_has_suffix(n, ".desktop")) {
+            g_free(path);
+            continue;
+        }
+        ParseJob *j = g_new0(ParseJob, 1);
+        j->path = path;
+        j->id = g_strconcat(prefix, n, NULL);
+        g_ptr_array_add(b->jobs, j);
+
+        Slot s = { .job = j };
+        g_array_append_val(b->slots, s);
+    }
+    g_array_index(b->dirs, CacheDir, self).count = b->slots->len - rec.first;
+
+    for (guint i = 0; i < subdirs->len; i++) {
+        const char *path = g_ptr_array_index(subdirs, i);
+        char *base = g_path_get_basename(path);
+        char *sub = g_strconcat(prefix, base, "-", NULL);
+        scan_dir(b, path, sub, self + 1);
+        g_free(sub);
+        g_free(base);
+    }
+    g_ptr_array_free(subdirs, TRUE);
+    g_ptr_array_free(names, TRUE);
+}
+
+// The dirs TryExec lookups depended on, for CacheExecDir.
+static GArray *exec_dirs(Builder *b) {
+    DesktopIndex *idx = b->idx;
+    GHashTable *seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    GArray *out = g_array_new(FALSE, TRUE, sizeof(CacheExecDir));
+    gboolean searched_path = FALSE;
+
+    for (guint i = 0; i < idx->n; i++) {
+        // A copy: interning below may move the string blob.
+        guint32 off = g_array_index(idx->own_cols[DESKTOP_FIELD_TRY_EXEC], guint32, i);
+        if (!idx->own_strings->str[off]) continue;
+        char *try_exec = g_strdup(idx->own_strings->str + off);
+
+        char **dirs;
+        if (g_path_is_absolute(try_exec)) {
+            dirs = g_new0(char *, 2);
+            dirs[0] = g_path_get_dirname(try_exec);
+        } else if (!searched_path) {
+            const char *env = g_getenv("PATH");
+            dirs = g_strsplit(env ? env : "", G_SEARCHPATH_SEPARATOR_S, -1);
+            searched_path = TRUE;
+        } else {
+            g_free(try_exec);
+            continue;
+        }
+        g_free(try_exec);
+
+        for (char **d = dirs; *d; d++) {
+            if (!**d || g_hash_table_contains(seen, *d)) continue;
+            g_hash_table_add(seen, g_strdup(*d));
+            CacheExecDir rec = { .path = blob_intern(b, *d), .mtime_ns = dir_mtime(*d) };
+            g_array_append_val(out, rec);
+        }
+        g_strfreev(dirs);
+    }
+    g_hash_table_destroy(seen);
+    return out;
+}
+
+static void cache_write(Builder *b, const char *path, guint32 context) {
+    DesktopIndex *idx = b->idx;
+    GArray *xdirs = exec_dirs(b);
+
+    CacheHeader h = {
+        .version = CACHE_VERSION,
+        .byte_order = CACHE_BYTE_ORDER,
+        .n_fields = DESKTOP_N_FIELDS,
+        .n_entries = idx->n,
+        .n_dirs = b->dirs->len,
+        .n_exec_dirs = xdirs->len,
+        .context = context,
+        .strings_len = (guint32)idx->own_strings->len,
+    };
+    memcpy(h.magic, CACHE_MAGIC, sizeof h.magic);
+    h.dirs_off = sizeof h;
+    h.exec_dirs_off = h.dirs_off + h.n_dirs * (guint32)sizeof(CacheDir);
+    h.cols_off = h.exec_dirs_off + h.n_exec_dirs * (guint32)sizeof(CacheExecDir);
+    h.flags_off = h.cols_off + idx->n * (guint32)sizeof(guint32) * DESKTOP_N_FIELDS;
+    h.strings_off = h.flags_off + idx->n;
+
+    GByteArray *out = g_byte_array_sized_new(h.strings_off + h.strings_len);
+    g_byte_array_append(out, (const guint8 *)&h, sizeof h);
+    g_byte_array_append(out, (const guint8 *)b->dirs->data, h.n_dirs * (guint)sizeof(CacheDir));
+    g_byte_array_append(out, (const guint8 *)xdirs->data, h.n_exec_dirs * (guint)sizeof(CacheExecDir));
+    for (guint f = 0; f < DESKTOP_N_FIELDS; f++) {
+        g_byte_array_append(out, (const guint8 *)idx->own_cols[f]->data, idx->n * (guint)sizeof(guint32));
+    }
+    g_byte_array_append(out, (const guint8 *)idx->own_flags->data, idx->n);
+    g_byte_array_append(out, (const guint8 *)idx->own_strings->str, h.strings_len);
+
+    // Written to a temporary file and renamed over the old one, so a
+    // running instance that has the old one mapped is unaffected.
+    GError *err = NULL;
+    char *dir = g_path_get_dirname(path);
+    if (g_mkdir_with_parents(dir, 0700) != 0) {
+        g_warning("desktop index: cannot create %s: %s", dir, g_strerror(errno));
+    } else if (!g_file_set_contents(path, (const char *)out->data, (gssize)out->len, &err)) {
+        g_warning("desktop index: cannot write %s: %s", path, err->message);
+        g_error_free(err);
+    }
+    g_free(dir);
+    g_byte_array_free(out, TRUE);
+    g_array_free(xdirs, TRUE);
+}
+
+// What the entries depend on besides the files (the desktop decides
+// OnlyShowIn/NotShowIn, PATH where TryExec is looked for): if any of it
+// differs, the cache is not used at all.
+static char *cache_context(char **top_dirs) {
+    const char *desktop = g_getenv("XDG_CURRENT_DESKTOP");
+    const char *search = g_getenv("PATH");
+    char *langs = g_strjoinv(":", (char **)g_get_language_names());
+    char *dirs = g_strjoinv(":", top_dirs);
+    char *context = g_strdup_printf("desktop=%s\npath=%s\nlangs=%s\ndirs=%s",
+                                    desktop ? desktop : "", search ? search : "", langs, dirs);
+    g_free(langs);
+    g_free(dirs);
+    return context;
+}
+
+static char **application_dirs(void) {
+    GPtrArray *dirs = g_ptr_array_new();
+    g_ptr_array_add(dirs, g_build_filename(g_get_user_data_dir(), "applications", NULL));
+    for (const char *const *d = g_get_system_data_dirs(); *d; d++) {
+        g_ptr_array_add(dirs, g_build_filename(*d, "applications", NULL));
+    }
+    g_ptr_array_add(dirs, NULL);
+    return (char **)g_ptr_array_free(dirs, FALSE);
+}
+
+static void build(DesktopIndex *idx, char **top_dirs, const Cache *old, GHashTable *dirty,
+                  gboolean exec_stale, const char *path, const char *context) {
+    for (guint f = 0; f < DESKTOP_N_FIELDS; f++) idx->own_cols[f] = g_array_new(FALSE, FALSE, sizeof(guint32));
+    idx->own_flags = g_array_new(FALSE, FALSE, sizeof(guint8));
+    idx->own_strings = g_string_new_len("", 1);     // offset 0: ""
+
+    Builder b = {
+        .idx = idx,
+        .interned = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL),
+        .seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL),
+        .desktops = NULL,
+        .langs = g_get_language_names(),
+        .old = old,
+        .dirty = dirty,
+        .exec_stale = exec_stale,
+        .dirs = g_array_new(FALSE, TRUE, sizeof(CacheDir)),
+        .slots = g_array_new(FALSE, FALSE, sizeof(Slot)),
+        .jobs = g_ptr_array_new_with_free_func((GDestroyNotify)parse_job_free),
+        .next_job = 0,
+    };
+    const char *current = g_getenv("XDG_CURRENT_DESKTOP");
+    if (current) b.desktops = g_strsplit(current, ":", -1);
+
+    // Walk the dirs, parse what changed in parallel, then merge in order.
+    for (char **d = top_dirs; *d; d++) scan_dir(&b, *d, "", 0);
+    parse_all(&b);
+    merge_slots(&b);
+    cache_write(&b, path, blob_intern(&b, context));
+
+    GPtrArray *dirs = g_ptr_array_new();
+    for (guint d = 0; d < b.dirs->len; d++) {
+        const CacheDir *cd = &g_array_index(b.dirs, CacheDir, d);
+        g_ptr_array_add(dirs, g_strdup(idx->own_strings->str + cd->path));
+    }
+    g_ptr_array_add(dirs, NULL);
+    idx->dirs = (char **)g_ptr_array_free(dirs, FALSE);
+
+    g_hash_table_destroy(b.interned);
+    g_hash_table_destroy(b.seen);
+    g_array_free(b.dirs, TRUE);
+    g_array_free(b.slots, TRUE);
+    g_ptr_array_free(b.jobs, TRUE);
+    g_strfreev(b.desktops);
+
+    for (guint f = 0; f < DESKTOP_N_FIELDS; f++) idx->cols[f] = (const guint32 *)idx->own_cols[f]->data;
+    idx->flags = (const guint8 *)idx->own_flags->data;
+    idx->strings = idx->own_strings->str;
+}
+
+static void build_lookups(DesktopIndex *idx) {
+    idx->by_id = g_hash_table_new(g_str_hash, g_str_equal);
+    idx->by_key = g_hash_table_new(g_str_hash, g_str_equal);
+    for (guint i = 0; i < idx->n; i++) {
+        if (idx->flags[i] & DESKTOP_ENTRY_INACTIVE) continue;
+        g_hash_table_insert(idx->by_id, (gpointer)desktop_index_get(idx, i, DESKTOP_FIELD_ID), GUINT_TO_POINTER(i + 1));
+
+        const char *key = desktop_index_get(idx, i, DESKTOP_FIELD_MATCH_KEY);
+        if (!g_hash_table_contains(idx->by_key, key)) g_hash_table_insert(idx->by_key, (gpointer)key, GUINT_TO_POINTER(i + 1));
+    }
+}
+
+static DesktopIndex *index_load(GHashTable *dirty) {
+    gint64 t0 = g_get_monotonic_time();
+
+    DesktopIndex *idx = g_new0(DesktopIndex, 1);
+    char **top_dirs = application_dirs();
+    char *context = cache_context(top_dirs);
+    char *path = cache_path();
+
+    Cache old;
+    gboolean have = cache_open(&old, path);
+    if (have && strcmp(old.strings + old.h->context, context) != 0) {
+        g_mapped_file_unref(old.map);
+        have = FALSE;
+    }
+
+    gboolean any_dirty = dirty && g_hash_table_size(dirty) > 0;
+    gboolean exec_fresh = have && cache_exec_fresh(&old);
+    if (have && !any_dirty && exec_fresh && cache_fresh(&old)) {
+        // Warm: the mapping is the index.
+        idx->source = DESKTOP_INDEX_WARM;
+        idx->map = old.map;
+        idx->n = old.h->n_entries;
+        for (guint f = 0; f < DESKTOP_N_FIELDS; f++) idx->cols[f] = old.cols[f];
+        idx->flags = old.flags;
+        idx->strings = old.strings;
+
+        GPtrArray *dirs = g_ptr_array_new();
+        for (guint d = 0; d < old.h->n_dirs; d++) g_ptr_array_add(dirs, g_strdup(old.strings + old.dirs[d].path));
+        g_ptr_array_add(dirs, NULL);
+        idx->dirs = (char **)g_ptr_array_free(dirs, FALSE);
+    } else {
+        idx->source = have ? DESKTOP_INDEX_PARTIAL : DESKTOP_INDEX_COLD;
+        build(idx, top_dirs, have ? &old : NULL, dirty, have && !exec_fresh, path, context);
+        if (have) g_mapped_file_unref(old.map);
+    }
+    g_free(path);
+    g_free(context);
+    g_strfreev(top_dirs);
+
+    build_lookups(idx);
+    idx->icons = g_ptr_array_new_full(idx->n, (GDestroyNotify)g_object_unref);
+    g_ptr_array_set_size(idx->icons, (gint)idx->n);
+    idx->app_infos = g_ptr_array_new_full(idx->n, (GDestroyNotify)g_object_unref);
+    g_ptr_array_set_size(idx->app_infos, (gint)idx->n);
+
+    g_debug("desktop index: %u entries, %s cache, %u dirs read, %.1f ms",
+            idx->n, desktop_index_source_name(idx->source), idx->dirs_read,
+            (g_get_monotonic_time() - t0) / 1000.0);
+    return idx;
+}
+
+DesktopIndex *desktop_index_new(void) {
+    return index_load(NULL);
+}
+
+DesktopIndex *desktop_index_update(GHashTable *dirty_dirs) {
+    return index_load(dirty_dirs);
+}
+
+static gboolean entry_equal(const DesktopIndex *a, guint i, const DesktopIndex *b, guint j) {
+    if (a->flags[i] != b->flags[j]) return FALSE;
+    for (guint f = 0; f < DESKTOP_N_FIELDS; f++) {
+        if (strcmp(desktop_index_get(a, i, f), desktop_index_get(b, j, f)) != 0) return FALSE;
+    }
+    return TRUE;
+}
+
+GArray *desktop_index_diff(const DesktopIndex *old, const DesktopIndex *new) {
+    GArray *changes = g_array_new(FALSE, FALSE, sizeof(DesktopChange));
+
+    GHashTableIter iter;
+    gpointer id, v;
+    g_hash_table_iter_init(&iter, old->by_id);
+    while (g_hash_table_iter_next(&iter, &id, &v)) {
+        int i = (int)GPOINTER_TO_UINT(v) - 1;
+        int j = desktop_index_lookup(new, id);
+        if (j >= 0 && entry_equal(old, (guint)i, new, (guint)j)) continue;
+
+        DesktopChange c = {
+            .kind = j >= 0 ? DESKTOP_CHANGE_CHANGED : DESKTOP_CHANGE_REMOVED,
+            .id = id,
+            .old_i = i,
+            .new_i = j,
+        };
+        g_array_append_val(changes, c);
+    }
+
+    g_hash_table_iter_init(&iter, new->by_id);
+    while (g_hash_table_iter_next(&iter, &id, &v)) {
+        if (g_hash_table_contains(old->by_id, id)) continue;
+
+        DesktopChange c = {
+            .kind = DESKTOP_CHANGE_ADDED,
+            .id = id,
+            .old_i = -1,
+            .new_i = (int)GPOINTER_TO_UINT(v) - 1,
+        };
+        g_array_append_val(changes, c);
+    }
+    return changes;
+}
+
+void desktop_index_free(DesktopIndex *idx) {
+    if (!idx) return;
+    if (idx->map) g_mapped_file_unref(idx->map);
+    for (guint f = 0; f < DESKTOP_N_FIELDS; f++) {
+        if (idx->own_cols[f]) g_array_free(idx->own_cols[f], TRUE);
+    }
+    if (idx->own_flags) g_array_free(idx->own_flags, TRUE);
+    if (idx->own_strings) g_string_free(idx->own_strings, TRUE);
+    g_hash_table_destroy(idx->by_id);
+    g_hash_table_destroy(idx->by_key);
+    g_ptr_array_free(idx->icons, TRUE);
+    g_ptr_array_free(idx->app_infos, TRUE);
+    g_strfreev(idx->dirs);
+    g_free(idx);
+}
+
+const char *desktop_index_source_name(DesktopIndexSource source) {
+    switch (source) {
+    case DESKTOP_INDEX_WARM:    return "warm";
+    case DESKTOP_INDEX_PARTIAL: return "partial";
+    default:                    return "cold";
+    }
+}
+
+int desktop_index_lookup(const DesktopIndex *idx, const char *desktop_id) {
+    if (!idx || !desktop_id) return -1;
+    return (int)GPOINTER_TO_UINT(g_hash_table_lookup(idx->by_id, desktop_id)) - 1;
+}
+
+int desktop_index_lookup_key(const DesktopIndex *idx, const char *match_key) {
+    if (!idx || !match_key) return -1;
+    return (int)GPOINTER_TO_UINT(g_hash_table_lookup(idx->by_key, match_key)) - 1;
+}
+
+const char *desktop_index_get(const DesktopIndex *idx, guint i, DesktopField field) {
+    if (!idx || i >= idx->n) return "";
+    return idx->strings + idx->cols[field][i];
+}
+
+guint desktop_index_flags(const DesktopIndex *idx, guint i) {
+    if (!idx || i >= idx->n) return 0;
+    return idx->flags[i];
+}
+
+gboolean desktop_index_listed(const DesktopIndex *idx, guint i) {
+    return (desktop_index_flags(idx, i) & (DESKTOP_ENTRY_SHOW | DESKTOP_ENTRY_INACTIVE)) == DESKTOP_ENTRY_SHOW;
+}
+
+// Absolute paths are files; anything else is a theme name, minus any
+// image extension (as GDesktopAppInfo does).
+GIcon *desktop_index_icon(DesktopIndex *idx, guint i) {
+    if (!idx || i >= idx->n) return NULL;
+
+    GIcon *icon = g_ptr_array_index(idx->icons, i);
+    if (icon) return icon;
+
+    const char *name = desktop_index_get(idx, i, DESKTOP_FIELD_ICON);
+    if (!*name) return NULL;
+
+    if (g_path_is_absolute(name)) {
+        GFile *file = g_file_new_for_path(name);
+        icon = g_file_icon_new(file);
+        g_object_unref(file);
+    } else if (g_str_has_suffix(name, ".png") || g_str_has_suffix(name, ".svg") || g_str_has_suffix(name, ".xpm")) {
+        char *base = g_strndup(name, strlen(name) - 4);
+        icon = g_themed_icon_new(base);
+        g_free(base);
+    } else {
+        icon = g_themed_icon_new(name);
+    }
+    g_ptr_array_index(idx->icons, i) = icon;
+    return icon;
+}
+
+GAppInfo *desktop_index_app_info(DesktopIndex *idx, guint i) {
+    if (!idx || i >= idx->n) return NULL;
+
+    GAppInfo *info = g_ptr_array_index(idx->app_infos, i);
+    if (info) return info;
+
+    const char *file = desktop_index_get(idx, i, DESKTOP_FIELD_FILE);
+    GDesktopAppInfo *app = *file ? g_desktop_app_info_new_from_filename(file) : NULL;
+    if (!app) return NULL;
+
+    info = G_APP_INFO(app);
+    g_ptr_array_index(idx->app_infos, i) = info;
+    return info;
+}
+
+void desktop_index_carry_over(DesktopIndex *new, DesktopIndex *old, const GArray *changes) {
+    GHashTable *changed = g_hash_table_new(g_str_hash, g_str_equal);
+    for (guint c = 0; changes && c < changes->len; c++) {
+        g_hash_table_add(changed, (gpointer)g_array_index(changes, DesktopChange, c).id);
+    }
+
+    GHashTableIter iter;
+    gpointer id, v;
+    g_hash_table_iter_init(&iter, old->by_id);
+    while (g_hash_table_iter_next(&iter, &id, &v)) {
+        guint i = GPOINTER_TO_UINT(v) - 1;
+        if (!g_ptr_array_index(old->app_infos, i) || g_hash_table_contains(changed, id)) continue;
+
+        int j = desktop_index_lookup(new, id);
+        if (j < 0 || g_ptr_array_index(new->app_infos, j)) continue;
+        g_ptr_array_index(new->app_infos, j) = g_steal_pointer(&g_ptr_array_index(old->app_infos, i));
+    }
+    g_hash_table_destroy(changed);
+}
@@ -1,23 +1,13 @@
 #include "desktop_match.h"
+#include "intern.h"
 
-#include <gio-unix-2.0/gio/gdesktopappinfo.h>
 #include <glib.h>
 #include <string.h>
 
-char *desktop_match_key(const char *desktop_id) {
+char *desktop_match_key_from(const char *wm_class, const char *desktop_id) {
+    if (wm_class && *wm_class) return g_ascii_strdown(wm_class, -1);
     if (!desktop_id || !*desktop_id) return g_strdup("");
 
-    GDesktopAppInfo *app = g_desktop_app_info_new(desktop_id);
-    if (app) {
-        const char *wm = g_desktop_app_info_get_string(app, "StartupWMClass");
-        if (wm && *wm) {
-            char *k = g_ascii_strdown(wm, -1);
-            g_object_unref(app);
-            return k;
-        }
-        g_object_unref(app);
-    }
-
     if (g_str_has_suffix(desktop_id, ".desktop")) {
         size_t n = strlen(desktop_id) - strlen(".desktop");
         char *base = g_strndup(desktop_id, (gsize)n);
@@ -28,3 +18,29 @@ char *desktop_match_key(const char *desktop_id) {
 
     return g_ascii_strdown(desktop_id, -1);
 }
+
+const char *desktop_match_key(const DesktopIndex *apps, const char *desktop_id) {
+    if (!desktop_id || !*desktop_id) return intern("");
+
+    int i = desktop_index_lookup(apps, desktop_id);
+    if (i >= 0) return intern_lower(desktop_index_get(apps, (guint)i, DESKTOP_FIELD_MATCH_KEY));
+
+    char *key = desktop_match_key_from(NULL, desktop_id);
+    const char *k = intern_lower(key);
+    g_free(key);
+    return k;
+}
+
+const char *desktop_match_resolve_class(const DesktopIndex *apps, const char *cls) {
+    if (!cls || !*cls) return NULL;
+
+    // Most apps name their entry after their class: prefer that entry if
+    // several share the key.
+    char *guess = g_strconcat(cls, ".desktop", NULL);
+    int i = desktop_index_lookup(apps, guess);
+    g_free(guess);
+    if (i < 0 || strcmp(desktop_index_get(apps, (guint)i, DESKTOP_FIELD_MATCH_KEY), cls) != 0) {
+        i = desktop_index_lookup_key(apps, cls);
+    }
+    return i >= 0 ? desktop_index_get(apps, (guint)i, DESKTOP_FIELD_ID) : NULL;
+}
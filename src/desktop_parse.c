@@ -0,0 +1,235 @@
+#include "desktop_parse.h"
+
+#include <string.h>
+
+// Locales past this many in langs are ignored; g_get_language_names()
+// rarely lists more than a handful.
+#define MAX_LANGS 16
+
+typedef enum { KEY_STRING, KEY_LOCALE_STRING, KEY_LIST, KEY_BOOLEAN } KeyKind;
+
+typedef struct {
+    const char *key;
+    KeyKind kind;
+    gsize offset;           // of the char* or gboolean in DesktopEntry
+} KeySpec;
+
+#define STR(k, f)  { k, KEY_STRING,        G_STRUCT_OFFSET(DesktopEntry, f) }
+#define LOC(k, f)  { k, KEY_LOCALE_STRING, G_STRUCT_OFFSET(DesktopEntry, f) }
+#define LIST(k, f) { k, KEY_LIST,          G_STRUCT_OFFSET(DesktopEntry, f) }
+#define BOOL(k, f) { k, KEY_BOOLEAN,       G_STRUCT_OFFSET(DesktopEntry, f) }
+
+static const KeySpec keys[] = {
+    STR("Type", type),
+    STR("TryExec", try_exec),
+    LOC("Name", name),
+    LOC("GenericName", generic_name),
+    LOC("Keywords", keywords),     // a list, but unescaped as a string (as GKeyFile does)
+    LOC("Icon", icon),
+    STR("Exec", exec),
+    STR("Path", workdir),
+    STR("StartupWMClass", wm_class),
+    LIST("Actions", actions),
+    LIST("OnlyShowIn", only_show_in),
+    LIST("NotShowIn", not_show_in),
+    BOOL("Terminal", terminal),
+    BOOL("NoDisplay", no_display),
+    BOOL("Hidden", hidden),
+};
+
+#undef STR
+#undef LOC
+#undef LIST
+#undef BOOL
+
+// A value as it sits in the mapped file, not yet unescaped.
+typedef struct {
+    const char *p;          // NULL: key not seen
+    gsize n;
+} Span;
+
+static const KeySpec *find_key(const char *k, gsize n) {
+    for (guint i = 0; i < G_N_ELEMENTS(keys); i++) {
+        if (strlen(keys[i].key) == n && memcmp(keys[i].key, k, n) == 0) return &keys[i];
+    }
+    return NULL;
+}
+
+// Position of the locale in langs (lower is better), or -1 if it does not
+// apply. langs already lists the fallbacks the spec asks for, in order:
+// lang_COUNTRY@MODIFIER, lang_COUNTRY, lang@MODIFIER, lang.
+static int locale_rank(const char *const *langs, guint n_langs, const char *loc, gsize n) {
+    for (guint i = 0; i < n_langs; i++) {
+        if (strlen(langs[i]) == n && memcmp(langs[i], loc, n) == 0) return (int)i;
+    }
+    return -1;
+}
+
+// The GKeyFile escapes: \s \n \t \r \\, and \; inside lists. In lists \\ and
+// \; stay escaped so the raw list can still be split. Anything else, a
+// trailing backslash or invalid UTF-8 makes GKeyFile reject the value:
+// NULL here too.
+static char *unescape(const char *s, gsize n, gboolean list) {
+    if (!g_utf8_validate(s, (gssize)n, NULL)) return NULL;
+    if (!memchr(s, '\\', n)) return g_strndup(s, n);
+
+    GString *out = g_string_sized_new(n);
+    for (gsize i = 0; i < n; i++) {
+        if (s[i] != '\\') {
+            g_string_append_c(out, s[i]);
+            continue;
+        }
+        char c = ++i < n ? s[i] : '\0';
+        switch (c) {
+        case 's':  g_string_append_c(out, ' ');  break;
+        case 'n':  g_string_append_c(out, '\n'); break;
+        case 't':  g_string_append_c(out, '\t'); break;
+        case 'r':  g_string_append_c(out, '\r'); break;
+        case '\\':
+            if (list) g_string_append(out, "\\\\");
+            else g_string_append_c(out, '\\');
+            break;
+        case ';':
+            if (list) {
+                g_string_append(out, "\\;");
+                break;
+            }
+            G_GNUC_FALLTHROUGH;
+        default:
+            g_string_free(out, TRUE);
+            return NULL;
+        }
+    }
+    return g_string_free(out, FALSE);
+}
+
+static gboolean is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// What g_key_file_get_(locale_)string/boolean would return for the key:
+// the best locale whose value is valid, else the unlocalized one.
+static void resolve(DesktopEntry *e, const KeySpec *spec, const Span *vals, guint n_langs) {
+    gpointer field = G_STRUCT_MEMBER_P(e, spec->offset);
+
+    if (spec->kind == KEY_BOOLEAN) {
+        const Span *v = &vals[n_langs];
+        *(gboolean *)field = v->p && ((v->n == 4 && memcmp(v->p, "true", 4) == 0)
+                                      || (v->n == 1 && *v->p == '1'));
+        return;
+    }
+
+    gboolean list = spec->kind == KEY_LIST;
+    for (guint r = 0; r <= n_langs; r++) {
+        if (!vals[r].p) continue;
+        char *s = unescape(vals[r].p, vals[r].n, list);
+        if (s) {
+            *(char **)field = s;
+            return;
+        }
+    }
+}
+
+gboolean desktop_entry_parse(const char *path, const char *const *langs, DesktopEntry *e) {
+    memset(e, 0, sizeof *e);
+
+    GMappedFile *map = g_mapped_file_new(path, FALSE, NULL);
+    if (!map) return FALSE;
+
+    const char *p = g_mapped_file_get_contents(map);
+    const char *end = p + g_mapped_file_get_length(map);
+    guint n_langs = 0;
+    while (langs && langs[n_langs] && n_langs < MAX_LANGS) n_langs++;
+
+    // Last value per key and locale (index n_langs: unlocalized). Keys are
+    // only resolved once the whole file is read: as in GKeyFile, a later
+    // line overrides an earlier one, and a repeated [Desktop Entry] group
+    // adds to the first.
+    Span vals[G_N_ELEMENTS(keys)][MAX_LANGS + 1];
+    memset(vals, 0, sizeof vals);
+
+    gboolean in_group = FALSE, found = FALSE, any_group = FALSE, ok = TRUE;
+    while (p && p < end) {
+        const char *line = p;
+        const char *eol = memchr(p, '\n', (gsize)(end - p));
+        if (!eol) eol = end;
+        p = eol + 1;
+
+        while (line < eol && is_space(*line)) line++;
+        const char *stop = eol;
+        while (stop > line && is_space(stop[-1])) stop--;
+        if (line == stop || *line == '#') continue;
+
+        if (*line == '[') {
+            in_group = (gsize)(stop - line) == strlen("[Desktop Entry]")
+                && memcmp(line, "[Desktop Entry]", strlen("[Desktop Entry]")) == 0;
+            // GDesktopAppInfo only takes files that start with the group.
+            if (!any_group) found = in_group;
+            any_group = TRUE;
+            continue;
+        }
+
+        // A stray line or a key outside any group fails the whole file in
+        // GKeyFile; the entry is dropped the same way here.
+        const char *eq = memchr(line, '=', (gsize)(stop - line));
+        if (!eq || !any_group) {
+            ok = FALSE;
+            break;
+        }
+        if (!in_group) continue;
+
+        const char *kend = eq;
+        while (kend > line && is_space(kend[-1])) kend--;
+        const char *val = eq + 1;
+        while (val < stop && is_space(*val)) val++;
+
+        // Key[locale]=value
+        const char *loc = memchr(line, '[', (gsize)(kend - line));
+        const KeySpec *spec = find_key(line, (gsize)((loc ? loc : kend) - line));
+        if (!spec) continue;
+
+        guint r = n_langs;
+        if (loc) {
+            if (spec->kind != KEY_LOCALE_STRING || kend[-1] != ']') continue;
+            int lr = locale_rank(langs, n_langs, loc + 1, (gsize)(kend - 1 - (loc + 1)));
+            if (lr < 0) continue;
+            r = (guint)lr;
+        }
+        vals[spec - keys][r] = (Span){ val, (gsize)(stop - val) };
+    }
+
+    found &= ok;
+    if (found) {
+        for (guint k = 0; k < G_N_ELEMENTS(keys); k++) resolve(e, &keys[k], vals[k], n_langs);
+    }
+
+    g_mapped_file_unref(map);
+    return found;
+}
+
+void desktop_entry_clear(DesktopEntry *e) {
+    for (guint i = 0; i < G_N_ELEMENTS(keys); i++) {
+        if (keys[i].kind == KEY_BOOLEAN) continue;
+        char **s = G_STRUCT_MEMBER_P(e, keys[i].offset);
+        g_clear_pointer(s, g_free);
+    }
+    memset(e, 0, sizeof *e);
+}
+
+gboolean desktop_list_contains_any(const char *list, char **names) {
+    if (!list || !names) return FALSE;
+
+    for (const char *p = list; *p; ) {
+        // Escaped characters (\; and \\) belong to the item.
+        const char *semi = p;
+        while (*semi && *semi != ';') semi += semi[0] == '\\' && semi[1] ? 2 : 1;
+        gsize n = (gsize)(semi - p);
+        if (!*semi) semi = NULL;
+        for (char **name = names; *name; name++) {
+            if (n > 0 && strlen(*name) == n && memcmp(*name, p, n) == 0) return TRUE;
+        }
+        if (!semi) break;
+        p = semi + 1;
+    }
+    return FALSE;
+}
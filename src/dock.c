@@ -1,31 +1,50 @@
 #include "dock.h"
-#include "hypr.h"
+#include "wintable.h"
 #include "config.h"
 #include "desktop_match.h"
+#include "intern.h"
+#include "icon_cache.h"
+#include "icon_pack.h"
 #include "launcher.h"
+#include "hypr.h"
 
-#include <gio-unix-2.0/gio/gdesktopappinfo.h>
+#include <gtk4-layer-shell/gtk4-layer-shell.h>
+#include <string.h>
 
 static void dock_item_free(gpointer p) {
     DockItem *it = (DockItem*)p;
     if (!it) return;
-    g_free(it->desktop_id);
-    g_free(it->match_key);
+    g_clear_object(&it->gicon);
+    g_array_unref(it->widgets);
     g_free(it);
 }
 
-static void rebuild_items_array(AppState *st) {
-    if (st->items) g_ptr_array_free(st->items, TRUE);
-    st->items = g_ptr_array_new_with_free_func(dock_item_free);
+// The widgets showing it on the dock in slot (zeroed until built).
+static DockItemWidgets *item_widgets(DockItem *it, guint slot) {
+    if (it->widgets->len <= slot) g_array_set_size(it->widgets, slot + 1);
+    return &g_array_index(it->widgets, DockItemWidgets, slot);
+}
+
+static void rebuild_index(AppState *st) {
+    if (st->item_index) g_hash_table_destroy(st->item_index);
+    st->item_index = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                           (GDestroyNotify)g_ptr_array_unref);
 }
 
-static void clear_box(GtkWidget *box) {
-    GtkWidget *child = gtk_widget_get_first_child(box);
-    while (child) {
-        GtkWidget *next = gtk_widget_get_next_sibling(child);
-        gtk_box_remove(GTK_BOX(box), child);
-        child = next;
+static void index_item(AppState *st, DockItem *it) {
+    GPtrArray *same = g_hash_table_lookup(st->item_index, it->match_key);
+    if (!same) {
+        same = g_ptr_array_new();
+        g_hash_table_insert(st->item_index, (gpointer)it->match_key, same);
     }
+    g_ptr_array_add(same, it);
+}
+
+static void unindex_item(AppState *st, DockItem *it) {
+    GPtrArray *same = g_hash_table_lookup(st->item_index, it->match_key);
+    if (!same) return;
+    g_ptr_array_remove(same, it);
+    if (same->len == 0) g_hash_table_remove(st->item_index, it->match_key);
 }
 
 gboolean idle_rebuild_config(gpointer data) {
@@ -46,7 +65,71 @@ static GtkWidget* make_dot(void) {
     return d;
 }
 
-static GtkWidget* make_app_widget(AppState *st, const char *desktop_id, int icon_size) {
+// With click_action=focus, a click on a running app focuses its most recent
+// window, or the next one if it already has focus. The lookup is served
+// from the window table and the dispatch goes over the request socket, so
+// nothing is spawned unless the app has no windows. Running-app section
+// entries (dynamic) exist because the app has windows, so they always focus.
+static void activate_item(AppState *st, const char *desktop_id, const char *match_key,
+                          gboolean dynamic, gboolean new_instance) {
+    if (!new_instance && st->cfg && (dynamic || st->cfg->click_action == DOCK_CLICK_FOCUS)) {
+        guint64 addr = wintable_pick_window(st->windows, match_key);
+        if (addr && hypr_focus_window(addr)) {
+            wintable_mark_focused(st->windows, addr);
+            dock_schedule_update(st);
+            return;
+        }
+    }
+
+    // Only a launch that started is waited for: a stale entry would be
+    // matched to some later, unrelated window.
+    if (launcher_launch(st->apps, desktop_id)) launch_stats_begin(st->launches, match_key);
+}
+
+static void on_dock_item_clicked(GtkButton *b, gpointer user_data) {
+    AppState *st = g_object_get_data(G_OBJECT(b), "app-state");
+    DockItem *it = user_data;
+    if (!st) return;
+
+    activate_item(st, it->desktop_id, it->match_key, it->dynamic, FALSE);
+}
+
+// Middle click always starts a new instance, whatever click_action says.
+static void on_dock_item_middle_click(GtkGestureClick *g, int n_press, double x, double y, gpointer user_data) {
+    (void)n_press; (void)x; (void)y;
+    GtkWidget *btn = gtk_event_controller_get_widget(GTK_EVENT_CONTROLLER(g));
+    AppState *st = g_object_get_data(G_OBJECT(btn), "app-state");
+    DockItem *it = user_data;
+    if (!st) return;
+
+    activate_item(st, it->desktop_id, it->match_key, FALSE, TRUE);
+}
+
+static void on_view_item_activated(gpointer item_data, guint button, gpointer user_data) {
+    AppState *st = user_data;
+    DockItem *it = item_data;
+
+    if (button == GDK_BUTTON_PRIMARY) activate_item(st, it->desktop_id, it->match_key, it->dynamic, FALSE);
+    else if (button == GDK_BUTTON_MIDDLE) activate_item(st, it->desktop_id, it->match_key, FALSE, TRUE);
+}
+
+// match_key may be NULL to take it from the entry. Everything comes from
+// the desktop index: no .desktop file is read here, however many docks
+// end up showing the item.
+static DockItem* make_app_item(AppState *st, const char *desktop_id, const char *match_key) {
+    DockItem *it = g_new0(DockItem, 1);
+    it->desktop_id = intern(desktop_id);
+    it->match_key  = match_key ? intern_lower(match_key) : desktop_match_key(st->apps, desktop_id);
+    it->widgets    = g_array_new(FALSE, TRUE, sizeof(DockItemWidgets));
+
+    int i = desktop_index_lookup(st->apps, desktop_id);
+    GIcon *gicon = i >= 0 ? desktop_index_icon(st->apps, (guint)i) : NULL;
+    it->gicon = gicon ? g_object_ref(gicon) : NULL;
+    return it;
+}
+
+// renderer=widgets: the button subtree for it on surface s.
+static void build_item_widgets(DockSurface *s, DockItem *it, DockItemWidgets *w) {
     GtkWidget *btn = gtk_button_new();
     gtk_button_set_has_frame(GTK_BUTTON(btn), FALSE);
     gtk_widget_add_css_class(btn, "icon");
@@ -54,15 +137,14 @@ static GtkWidget* make_app_widget(AppState *st, const char *desktop_id, int icon
     GtkWidget *v = gtk_box_new(GTK_ORIENTATION_VERTICAL, 4);
     gtk_widget_set_halign(v, GTK_ALIGN_CENTER);
 
+    // From the icon cache: the same texture on every dock of this scale.
     GtkWidget *img = NULL;
-    GDesktopAppInfo *app = g_desktop_app_info_new(desktop_id);
-    if (app) {
-        GIcon *gicon = g_app_info_get_icon(G_APP_INFO(app));
-        img = gtk_image_new_from_gicon(gicon);
-        gtk_image_set_pixel_size(GTK_IMAGE(img), icon_size);
-        g_object_unref(app);
+    if (it->gicon) {
+        img = gtk_image_new();
+        icon_cache_set_image(GTK_IMAGE(img), it->gicon, s->icon_size, gdk_monitor_get_scale_factor(s->monitor));
+        gtk_image_set_pixel_size(GTK_IMAGE(img), s->icon_size);
     } else {
-        img = gtk_label_new(desktop_id);
+        img = gtk_label_new(it->desktop_id);
     }
 
     GtkWidget *dot = make_dot();
@@ -71,59 +153,508 @@ static GtkWidget* make_app_widget(AppState *st, const char *desktop_id, int icon
     gtk_box_append(GTK_BOX(v), dot);
     gtk_button_set_child(GTK_BUTTON(btn), v);
 
-    // click -> launch (user_data is strdup'd desktop_id)
-    g_signal_connect_data(
-        btn, "clicked",
-        G_CALLBACK(on_app_clicked),
-        g_strdup(desktop_id),
-        (GClosureNotify)g_free,
-        0
-    );
+    // click -> launch or focus; the item outlives its buttons
+    g_object_set_data(G_OBJECT(btn), "app-state", s->st);
+    g_signal_connect(btn, "clicked", G_CALLBACK(on_dock_item_clicked), it);
 
-    // track dot visibility for running refresh
-    DockItem *it = g_new0(DockItem, 1);
-    it->desktop_id = g_strdup(desktop_id);
-    it->match_key  = desktop_match_key(desktop_id);
-    it->dot        = dot;
-    g_ptr_array_add(st->items, it);
+    GtkGesture *middle = gtk_gesture_click_new();
+    gtk_gesture_single_set_button(GTK_GESTURE_SINGLE(middle), GDK_BUTTON_MIDDLE);
+    g_signal_connect(middle, "released", G_CALLBACK(on_dock_item_middle_click), it);
+    gtk_widget_add_controller(btn, GTK_EVENT_CONTROLLER(middle));
 
-    return btn;
+    w->button = btn;
+    w->icon   = img;
+    w->dot    = dot;
 }
 
-static void dock_build_from_cfg(AppState *st, const DockConfig *cfg) {
-    clear_box(st->dock_box);
-    rebuild_items_array(st);
+/* Item placement and state, for either renderer and every dock */
 
-    if (cfg && cfg->pinned_apps) {
-        for (gchar **p = cfg->pinned_apps; *p; p++) {
-            if (**p == '\0') continue;
-            GtkWidget *w = make_app_widget(st, *p, cfg->icon_size);
-            gtk_box_append(GTK_BOX(st->dock_box), w);
+static gboolean surface_place_after(DockSurface *s, DockItem *it, DockItem *prev) {
+    DockItemWidgets *w = item_widgets(it, s->slot);
+
+    if (s->view) {
+        DockView *v = DOCK_VIEW(s->view);
+        DockViewItem *after = prev ? item_widgets(prev, s->slot)->cell : NULL;
+        if (!w->cell) {
+            w->cell = dock_view_insert_after(v, after, it->gicon, it->desktop_id, it);
+            return FALSE;
         }
+        if (dock_view_get_prev(v, w->cell) == after) return FALSE;
+        dock_view_move_after(v, w->cell, after);
+        return TRUE;
     }
 
-    // Update indicators once after building
-    dock_refresh_running(st);
+    GtkBox *box = GTK_BOX(s->box);
+    GtkWidget *after = prev ? item_widgets(prev, s->slot)->button : NULL;
+    if (!w->button) {
+        build_item_widgets(s, it, w);
+        gtk_box_insert_child_after(box, w->button, after);
+        return FALSE;
+    }
+    if (gtk_widget_get_prev_sibling(w->button) == after) return FALSE;
+    gtk_box_reorder_child_after(box, w->button, after);
+    return TRUE;
+}
+
+static void surface_append(DockSurface *s, DockItem *it) {
+    DockItemWidgets *w = item_widgets(it, s->slot);
+
+    if (s->view) {
+        w->cell = dock_view_append(DOCK_VIEW(s->view), it->gicon, it->desktop_id, it);
+        return;
+    }
+    build_item_widgets(s, it, w);
+    gtk_box_append(GTK_BOX(s->box), w->button);
 }
 
-gboolean dock_refresh_running(gpointer user_data) {
-    AppState *st = (AppState*)user_data;
-    if (!st) return G_SOURCE_REMOVE;
+static void surface_remove(DockSurface *s, DockItem *it) {
+    if (it->widgets->len <= s->slot) return;
+    DockItemWidgets *w = &g_array_index(it->widgets, DockItemWidgets, s->slot);
 
-    if (!st->items || st->items->len == 0) return G_SOURCE_CONTINUE;
+    if (s->view && w->cell) dock_view_remove(DOCK_VIEW(s->view), w->cell);
+    else if (w->button) gtk_box_remove(GTK_BOX(s->box), w->button);
+    memset(w, 0, sizeof *w);
+}
 
-    GHashTable *counts = hypr_get_running_class_counts();
+// Places it right after prev (NULL = first) on every dock, inserting it
+// where it is not shown yet. Returns TRUE if an already shown item moved.
+static gboolean item_place_after(AppState *st, DockItem *it, DockItem *prev) {
+    gboolean moved = FALSE;
+    for (guint i = 0; i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (s && surface_place_after(s, it, prev)) moved = TRUE;
+    }
+    return moved;
+}
 
-    for (guint i = 0; i < st->items->len; i++) {
-        DockItem *it = g_ptr_array_index(st->items, i);
-        gpointer v = g_hash_table_lookup(counts, it->match_key);
-        int c = v ? GPOINTER_TO_INT(v) : 0;
+static void item_append(AppState *st, DockItem *it) {
+    for (guint i = 0; i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (s) surface_append(s, it);
+    }
+}
+
+static void item_remove(AppState *st, DockItem *it) {
+    for (guint i = 0; i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (s) surface_remove(s, it);
+    }
+}
+
+static void items_set_icon_size(AppState *st, GPtrArray *items, int icon_size) {
+    for (guint i = 0; i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (!s) continue;
+        s->icon_size = icon_size;
+        if (s->view) {
+            dock_view_set_icon_size(DOCK_VIEW(s->view), icon_size);
+            continue;
+        }
+        for (guint j = 0; items && j < items->len; j++) {
+            DockItem *it = g_ptr_array_index(items, j);
+            DockItemWidgets *w = item_widgets(it, s->slot);
+            if (!GTK_IS_IMAGE(w->icon) || !it->gicon) continue;
+
+            icon_cache_set_image(GTK_IMAGE(w->icon), it->gicon, icon_size, gdk_monitor_get_scale_factor(s->monitor));
+            gtk_image_set_pixel_size(GTK_IMAGE(w->icon), icon_size);
+        }
+    }
+}
+
+static const double dot_opacity[] = {
+    [DOCK_DOT_NONE]      = 0.0,
+    [DOCK_DOT_ELSEWHERE] = 0.5,
+    [DOCK_DOT_HERE]      = 1.0,
+};
+
+static guint surface_set_focused(DockSurface *s, DockItem *it, gboolean on) {
+    DockItemWidgets *w = item_widgets(it, s->slot);
+    if (w->focused == on) return 0;
+
+    if (s->view) dock_view_set_focused(DOCK_VIEW(s->view), w->cell, on);
+    else if (on) gtk_widget_add_css_class(w->button, "focused");
+    else gtk_widget_remove_css_class(w->button, "focused");
+    w->focused = on;
+    return 1;
+}
+
+static guint set_focused(AppState *st, const char *match_key, gboolean on) {
+    GPtrArray *same = match_key ? g_hash_table_lookup(st->item_index, match_key) : NULL;
+    if (!same) return 0;
+
+    guint mutations = 0;
+    for (guint i = 0; i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (!s) continue;
+        for (guint j = 0; j < same->len; j++) mutations += surface_set_focused(s, g_ptr_array_index(same, j), on);
+    }
+    return mutations;
+}
+
+/* Running-app section */
+
+static gboolean is_pinned(AppState *st, const char *match_key) {
+    GPtrArray *same = g_hash_table_lookup(st->item_index, match_key);
+    for (guint i = 0; same && i < same->len; i++) {
+        if (!((DockItem*)g_ptr_array_index(same, i))->dynamic) return TRUE;
+    }
+    return FALSE;
+}
+
+static void remove_running_item(AppState *st, guint i) {
+    DockItem *it = g_ptr_array_index(st->running_items, i);
+    unindex_item(st, it);
+    item_remove(st, it);
+    g_ptr_array_remove_index(st->running_items, i);   // frees it
+}
+
+static void surface_ensure_separator(DockSurface *s) {
+    if (s->running_sep || s->view) return;
+    s->running_sep = gtk_separator_new(GTK_ORIENTATION_VERTICAL);
+    gtk_widget_add_css_class(s->running_sep, "running-separator");
+    gtk_box_append(GTK_BOX(s->box), s->running_sep);
+}
+
+static void surface_update_separator(DockSurface *s) {
+    AppState *st = s->st;
+    gboolean want_sep = st->running_items && st->running_items->len > 0 && st->items && st->items->len > 0;
+
+    if (s->running_sep && gtk_widget_get_visible(s->running_sep) != want_sep) {
+        gtk_widget_set_visible(s->running_sep, want_sep);
+    }
+    if (s->view && st->running_items) {
+        for (guint i = 0; i < st->running_items->len; i++) {
+            DockItem *it = g_ptr_array_index(st->running_items, i);
+            dock_view_set_separator_before(DOCK_VIEW(s->view), item_widgets(it, s->slot)->cell, want_sep && i == 0);
+        }
+    }
+}
+
+// The app a pinned or running entry already stands for. Both lists are
+// dock-sized, and this only runs for classes that just appeared.
+static gboolean has_item_for(AppState *st, const char *desktop_id) {
+    GPtrArray *lists[] = { st->items, st->running_items };
+    for (guint l = 0; l < G_N_ELEMENTS(lists); l++) {
+        for (guint i = 0; lists[l] && i < lists[l]->len; i++) {
+            if (((DockItem*)g_ptr_array_index(lists[l], i))->desktop_id == desktop_id) return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+// Gives cls a running entry if it has windows and resolves to an app the
+// dock does not show yet. A class resolving to an app that already has an
+// entry is remembered in running_aliases, so it can take over once that
+// entry's own class closes its last window.
+static void add_running_class(AppState *st, const char *cls) {
+    if (!*cls || wintable_class_count(st->windows, cls) == 0) return;
+    if (g_hash_table_contains(st->item_index, cls)) return;   // pinned or already listed
+
+    const char *found = desktop_match_resolve_class(st->apps, cls);
+    if (!found) return;
+
+    const char *desktop_id = intern(found);
+    if (has_item_for(st, desktop_id)) {
+        g_hash_table_insert(st->running_aliases, (gpointer)cls, (gpointer)desktop_id);
+        return;
+    }
+
+    for (guint i = 0; i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (s) surface_ensure_separator(s);
+    }
+
+    DockItem *it = make_app_item(st, desktop_id, cls);
+    it->dynamic = TRUE;
+    item_append(st, it);
+
+    g_ptr_array_add(st->running_items, it);
+    index_item(st, it);
+}
+
+// Adds and removes running-section entries to match the window table.
+// Only the entries that come and go are touched; pinned items and the
+// other running entries stay where they are. Only classes whose counts
+// moved since the last call are looked at, unless running_full_sync asks
+// for a full pass (pins or installed apps changed).
+static void sync_running_items(AppState *st) {
+    if (!st->running_items) st->running_items = g_ptr_array_new_with_free_func(dock_item_free);
+    if (!st->running_aliases) st->running_aliases = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    WinTable *t = st->windows;
+    gboolean enabled = st->cfg && st->cfg->show_running;
+    gboolean full = st->running_full_sync;
+    st->running_full_sync = FALSE;
+
+    // Drop apps whose last window closed, or that got pinned meanwhile.
+    gboolean removed = FALSE;
+    for (guint i = st->running_items->len; i-- > 0; ) {
+        DockItem *it = g_ptr_array_index(st->running_items, i);
+        if (!enabled || wintable_class_count(t, it->match_key) == 0 || is_pinned(st, it->match_key)) {
+            remove_running_item(st, i);
+            removed = TRUE;
+        }
+    }
+
+    if (full) g_hash_table_remove_all(st->running_aliases);
+
+    if (enabled && full) {
+        for (guint c = 0; c < t->classes->len; c++) {
+            add_running_class(st, g_array_index(t->classes, ClassEntry, c).key);
+        }
+    } else if (enabled) {
+        for (guint i = 0; i < t->changed->len; i++) {
+            add_running_class(st, wintable_class_key(t, g_array_index(t->changed, guint32, i)));
+        }
+    }
+
+    // An app lost its entry: a second class of it may still have windows.
+    if (enabled && removed && g_hash_table_size(st->running_aliases) > 0) {
+        GPtrArray *retry = g_ptr_array_new();
+        GHashTableIter it;
+        gpointer cls, desktop_id;
+        g_hash_table_iter_init(&it, st->running_aliases);
+        while (g_hash_table_iter_next(&it, &cls, &desktop_id)) {
+            if (has_item_for(st, desktop_id)) continue;
+            g_ptr_array_add(retry, cls);
+            g_hash_table_iter_remove(&it);
+        }
+        for (guint i = 0; i < retry->len; i++) add_running_class(st, g_ptr_array_index(retry, i));
+        g_ptr_array_free(retry, TRUE);
+    }
+    wintable_clear_changed(t);
+
+    for (guint i = 0; i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (s) surface_update_separator(s);
+    }
+}
+
+static guint apply_levels(AppState *st, DockSurface *s, GPtrArray *items, int mon) {
+    guint mutations = 0;
+    if (!items) return 0;
+
+    for (guint i = 0; i < items->len; i++) {
+        DockItem *it = g_ptr_array_index(items, i);
+        DockItemWidgets *w = item_widgets(it, s->slot);
+        int total = wintable_class_count(st->windows, it->match_key);
+        int here = (mon >= 0) ? wintable_class_count_on(st->windows, it->match_key, mon) : total;
+
+        DockDotLevel level = (here > 0) ? DOCK_DOT_HERE : (total > 0) ? DOCK_DOT_ELSEWHERE : DOCK_DOT_NONE;
+        if (level == w->level) continue;
+
+        if (s->view) dock_view_set_dot(DOCK_VIEW(s->view), w->cell, dot_opacity[level]);
         // gtk_widget_set_visible(it->dot, (c > 0));
-				gtk_widget_set_opacity(it->dot, (c > 0) ? 1.0 : 0.0);
+				else gtk_widget_set_opacity(w->dot, dot_opacity[level]);
+        w->level = level;
+        mutations++;
+    }
+    return mutations;
+}
+
+static guint surface_apply_levels(DockSurface *s) {
+    AppState *st = s->st;
+    int mon = wintable_monitor_slot(st->windows, gdk_monitor_get_connector(s->monitor));
+    return apply_levels(st, s, st->items, mon) + apply_levels(st, s, st->running_items, mon);
+}
+
+void dock_apply_running(AppState *st) {
+    if (!st || !st->items) return;
+
+    sync_running_items(st);
+
+    // Each dock gives windows on its own monitor a full dot and windows
+    // only on other monitors a dimmed one. Only dots whose level moved
+    // are touched.
+    guint mutations = 0;
+    for (guint i = 0; i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (s) mutations += surface_apply_levels(s);
+    }
+
+    // Focus moves between at most two apps: look both up in the index.
+    const char *active = wintable_active_class(st->windows);
+    if (active != st->focused_key) {
+        mutations += set_focused(st, st->focused_key, FALSE);
+        mutations += set_focused(st, active, TRUE);
+        st->focused_key = active;
+    }
+
+    st->dock_mutations += mutations;
+    g_debug("dock: indicator update, %u widget mutations", mutations);
+}
+
+/* Frame-aligned indicator updates */
+
+// Tick callbacks only run on mapped widgets.
+static DockSurface *mapped_surface(AppState *st) {
+    for (guint i = 0; st->docks && i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (s && gtk_widget_get_mapped(s->box)) return s;
+    }
+    return NULL;
+}
+
+static gboolean update_tick_cb(GtkWidget *w, GdkFrameClock *clock, gpointer data) {
+    (void)w; (void)clock;
+    AppState *st = data;
+
+    st->update_tick_id = 0;
+    st->update_tick_widget = NULL;
+    st->updates_applied++;
+    dock_apply_running(st);
+    return G_SOURCE_REMOVE;
+}
+
+// Any dock's frame clock will do: the model is shared and every dock is
+// updated in the same pass.
+static void request_update_frame(AppState *st) {
+    DockSurface *s = mapped_surface(st);
+    if (!s) {
+        // No dock on screen, nothing to draw: keep the model current anyway.
+        st->updates_applied++;
+        dock_apply_running(st);
+        return;
+    }
+    st->update_tick_widget = s->box;
+    st->update_tick_id = gtk_widget_add_tick_callback(s->box, update_tick_cb, st, NULL);
+}
+
+static gboolean update_debounce_cb(gpointer data) {
+    AppState *st = data;
+    st->update_timer_id = 0;
+
+    // Trailing edge: keep waiting while requests are still arriving.
+    gint64 quiet_ms = (g_get_monotonic_time() - st->update_last_request_us) / 1000;
+    int debounce = st->cfg ? st->cfg->refresh_debounce_ms : 0;
+    if (quiet_ms < debounce) {
+        st->update_timer_id = g_timeout_add((guint)(debounce - quiet_ms), update_debounce_cb, st);
+        return G_SOURCE_REMOVE;
     }
 
-    g_hash_table_destroy(counts);
-    return G_SOURCE_CONTINUE;
+    request_update_frame(st);
+    return G_SOURCE_REMOVE;
+}
+
+void dock_schedule_update(AppState *st) {
+    if (!st || !st->docks) return;
+
+    st->update_requests++;
+    st->update_last_request_us = g_get_monotonic_time();
+
+    // A tick on a dock unmapped since would never fire: start over.
+    if (st->update_tick_id && !gtk_widget_get_mapped(st->update_tick_widget)) {
+        gtk_widget_remove_tick_callback(st->update_tick_widget, st->update_tick_id);
+        st->update_tick_id = 0;
+        st->update_tick_widget = NULL;
+    }
+
+    // Already waiting for a frame or the debounce: this request rides along.
+    if (st->update_tick_id || st->update_timer_id) {
+        st->updates_merged++;
+        return;
+    }
+
+    int debounce = st->cfg ? st->cfg->refresh_debounce_ms : 0;
+    if (debounce > 0) {
+        st->update_timer_id = g_timeout_add((guint)debounce, update_debounce_cb, st);
+    } else {
+        request_update_frame(st);
+    }
+}
+
+void dock_log_stats(AppState *st) {
+    if (!st) return;
+    g_message("Dock updates: %" G_GUINT64_FORMAT " requested, %" G_GUINT64_FORMAT
+              " applied, %" G_GUINT64_FORMAT " merged, %" G_GUINT64_FORMAT " widget mutations",
+              st->update_requests, st->updates_applied, st->updates_merged, st->dock_mutations);
+}
+
+// Brings the dock in line with cfg's pinned list, keyed by desktop id:
+// existing buttons are kept (and moved if reordered), and only added or
+// removed apps create or destroy widgets. Kept items never re-read their
+// .desktop file. old_icon_size is what the kept icons currently use.
+static void dock_reconcile(AppState *st, const DockConfig *cfg, int old_icon_size) {
+    // interned desktop id -> queue of current items (a list may pin an id twice)
+    GHashTable *old = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_queue_free);
+    GPtrArray *prev_items = st->items;
+    if (prev_items) {
+        g_ptr_array_set_free_func(prev_items, NULL);
+        for (guint i = 0; i < prev_items->len; i++) {
+            DockItem *it = g_ptr_array_index(prev_items, i);
+            GQueue *q = g_hash_table_lookup(old, it->desktop_id);
+            if (!q) {
+                q = g_queue_new();
+                g_hash_table_insert(old, (gpointer)it->desktop_id, q);
+            }
+            g_queue_push_tail(q, it);
+        }
+    }
+
+    GPtrArray *items = g_ptr_array_new_with_free_func(dock_item_free);
+    int icon_size = cfg ? cfg->icon_size : old_icon_size;
+    DockItem *prev = NULL;
+    guint created = 0, moved = 0;
+
+    if (icon_size != old_icon_size) {
+        items_set_icon_size(st, prev_items, icon_size);
+        items_set_icon_size(st, st->running_items, icon_size);
+    }
+
+    if (cfg && cfg->pinned_apps) {
+        for (gchar **p = cfg->pinned_apps; *p; p++) {
+            if (**p == '\0') continue;
+
+            GQueue *q = g_hash_table_lookup(old, intern(*p));
+            DockItem *it = q ? g_queue_pop_head(q) : NULL;
+
+            if (!it) {
+                it = make_app_item(st, *p, NULL);
+                created++;
+            }
+            if (item_place_after(st, it, prev)) moved++;
+
+            g_ptr_array_add(items, it);
+            prev = it;
+        }
+    }
+
+    // Whatever was not claimed is no longer pinned.
+    guint removed = 0;
+    GHashTableIter iter;
+    gpointer qp;
+    GPtrArray *dead = g_ptr_array_new_with_free_func(dock_item_free);
+    g_hash_table_iter_init(&iter, old);
+    while (g_hash_table_iter_next(&iter, NULL, &qp)) {
+        DockItem *it;
+        while ((it = g_queue_pop_head(qp))) {
+            item_remove(st, it);
+            g_ptr_array_add(dead, it);
+            removed++;
+        }
+    }
+    g_hash_table_destroy(old);
+    g_ptr_array_free(dead, TRUE);
+    if (prev_items) g_ptr_array_free(prev_items, TRUE);
+
+    st->items = items;
+    rebuild_index(st);
+    for (guint i = 0; i < items->len; i++) index_item(st, g_ptr_array_index(items, i));
+    if (st->running_items) {
+        for (guint i = 0; i < st->running_items->len; i++) index_item(st, g_ptr_array_index(st->running_items, i));
+    }
+
+    // New items start unfocused; bring them in line with the focused app.
+    st->dock_mutations += set_focused(st, st->focused_key, TRUE);
+
+    g_debug("dock: reconciled %u items (%u created, %u moved, %u removed)",
+            items->len, created, moved, removed);
+
+    // Update indicators once (from the cached window table); only the new
+    // items' dots actually change. This also drops running-section entries
+    // for apps that just got pinned, and brings back unpinned ones.
+    st->running_full_sync = TRUE;
+    dock_apply_running(st);
 }
 
 void rebuild_dock_from_config(AppState *st) {
@@ -131,30 +662,278 @@ void rebuild_dock_from_config(AppState *st) {
 
     DockConfig *newcfg = dock_config_load();
 
-    // Build UI from new config first, then swap ownership
-    dock_build_from_cfg(st, newcfg);
+    // Reconcile UI against the new config first, then swap ownership
+    dock_reconcile(st, newcfg, st->cfg ? st->cfg->icon_size : newcfg->icon_size);
+    for (guint i = 0; i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (s && s->view) dock_view_set_magnify(DOCK_VIEW(s->view), newcfg->magnify);
+    }
+
+    icon_cache_set_budget(newcfg->icon_cache_bytes);
 
     if (st->cfg) dock_config_free(st->cfg);
     st->cfg = newcfg;
+    dock_update_icon_pack(st);
+}
+
+void dock_update_icon_pack(AppState *st) {
+    if (!st || !st->cfg || !st->apps) return;
+    int sizes[] = { st->cfg->icon_size, st->cfg->searcher_icon_size };
+    icon_pack_ensure(st->apps, sizes, G_N_ELEMENTS(sizes));
+}
+
+// st->apps is already the new index. Pinned items whose entry changed get
+// a fresh match key and icon and are rebuilt in place on every dock;
+// running entries for them are dropped and re-resolved by the update, which
+// also picks up classes that a newly installed entry now resolves.
+void dock_apps_changed(AppState *st, const GArray *changes) {
+    if (!st || !st->items || !changes || changes->len == 0) return;
+
+    GHashTable *ids = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (guint i = 0; i < changes->len; i++) {
+        g_hash_table_add(ids, (gpointer)intern(g_array_index(changes, DesktopChange, i).id));
+    }
+
+    guint rebuilt = 0;
+    for (guint j = 0; j < st->items->len; j++) {
+        DockItem *it = g_ptr_array_index(st->items, j);
+        if (!g_hash_table_contains(ids, it->desktop_id)) continue;
+
+        unindex_item(st, it);
+        it->match_key = desktop_match_key(st->apps, it->desktop_id);
+        index_item(st, it);
+
+        int e = desktop_index_lookup(st->apps, it->desktop_id);
+        GIcon *gicon = e >= 0 ? desktop_index_icon(st->apps, (guint)e) : NULL;
+        g_clear_object(&it->gicon);
+        it->gicon = gicon ? g_object_ref(gicon) : NULL;
+
+        DockItem *prev = j > 0 ? g_ptr_array_index(st->items, j - 1) : NULL;
+        for (guint i = 0; i < st->docks->len; i++) {
+            DockSurface *s = g_ptr_array_index(st->docks, i);
+            if (!s) continue;
+            surface_remove(s, it);
+            surface_place_after(s, it, prev);
+        }
+        rebuilt++;
+    }
+
+    for (guint i = st->running_items ? st->running_items->len : 0; i-- > 0; ) {
+        DockItem *it = g_ptr_array_index(st->running_items, i);
+        if (g_hash_table_contains(ids, it->desktop_id)) remove_running_item(st, i);
+    }
+    g_hash_table_destroy(ids);
+
+    // Rebuilt widgets start unfocused and without a dot.
+    st->dock_mutations += set_focused(st, st->focused_key, TRUE);
+    g_debug("dock: %u desktop entries changed, %u pinned items rebuilt", changes->len, rebuilt);
+    st->running_full_sync = TRUE;
+    dock_apply_running(st);
+}
+
+/* One dock window per monitor */
+
+// Builds the widgets for every current item on a fresh dock, in dock
+// order. Items and their icons already exist; only widgets are created.
+static void surface_populate(DockSurface *s) {
+    AppState *st = s->st;
+
+    for (guint i = 0; st->items && i < st->items->len; i++) {
+        surface_append(s, g_ptr_array_index(st->items, i));
+    }
+    if (st->running_items && st->running_items->len > 0) {
+        surface_ensure_separator(s);
+        for (guint i = 0; i < st->running_items->len; i++) {
+            surface_append(s, g_ptr_array_index(st->running_items, i));
+        }
+    }
+    surface_update_separator(s);
+
+    guint mutations = 0;
+    if (st->items) mutations += surface_apply_levels(s);
+    GPtrArray *same = st->focused_key ? g_hash_table_lookup(st->item_index, st->focused_key) : NULL;
+    for (guint i = 0; same && i < same->len; i++) mutations += surface_set_focused(s, g_ptr_array_index(same, i), TRUE);
+    st->dock_mutations += mutations;
+}
+
+static DockSurface *surface_new(AppState *st, GdkMonitor *mon, guint slot) {
+    DockSurface *s = g_new0(DockSurface, 1);
+    s->st = st;
+    s->slot = slot;
+    s->monitor = g_object_ref(mon);
+    s->icon_size = st->cfg->icon_size;
+
+    // Window
+    GtkWidget *win = gtk_application_window_new(st->app);
+    gtk_window_set_decorated(GTK_WINDOW(win), FALSE);
+    gtk_window_set_resizable(GTK_WINDOW(win), FALSE);
+
+    // Layer shell (GTK4), full width of its own monitor
+    GdkRectangle geo;
+    gdk_monitor_get_geometry(mon, &geo);
+    gtk_layer_init_for_window(GTK_WINDOW(win));
+    gtk_layer_set_layer(GTK_WINDOW(win), GTK_LAYER_SHELL_LAYER_TOP);
+    gtk_layer_set_monitor(GTK_WINDOW(win), mon);
+    gtk_layer_set_anchor(GTK_WINDOW(win), GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
+    gtk_layer_set_anchor(GTK_WINDOW(win), GTK_LAYER_SHELL_EDGE_LEFT, TRUE);
+    gtk_layer_set_anchor(GTK_WINDOW(win), GTK_LAYER_SHELL_EDGE_RIGHT, TRUE);
+    gtk_layer_auto_exclusive_zone_enable(GTK_WINDOW(win));
+    gtk_window_set_default_size(GTK_WINDOW(win), geo.width, 1); // full width, minimal height
+
+    gtk_widget_add_css_class(win, "dock-window");
+
+    // Full-width parent with centered dock
+    GtkWidget *outer = gtk_center_box_new();
+    gtk_widget_set_hexpand(outer, TRUE);
+    gtk_widget_set_halign(outer, GTK_ALIGN_FILL);
+
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+    gtk_widget_add_css_class(box, "dock");
+    gtk_widget_set_halign(box, GTK_ALIGN_CENTER);
+
+    gtk_center_box_set_center_widget(GTK_CENTER_BOX(outer), box);
+    gtk_window_set_child(GTK_WINDOW(win), outer);
+
+    s->window = win;
+    s->box = box;
+
+    if (st->cfg->renderer == DOCK_RENDER_SNAPSHOT) {
+        s->view = dock_view_new(st->cfg->icon_size);
+        dock_view_set_activate_func(DOCK_VIEW(s->view), on_view_item_activated, st);
+        dock_view_set_magnify(DOCK_VIEW(s->view), st->cfg->magnify);
+        gtk_box_append(GTK_BOX(box), s->view);
+    }
+
+    surface_populate(s);
+    gtk_window_present(GTK_WINDOW(win));
+    return s;
+}
+
+static void surface_free(DockSurface *s) {
+    AppState *st = s->st;
+
+    // A pending frame tick dies with the widget without firing.
+    gboolean had_tick = st->update_tick_id && st->update_tick_widget == s->box;
+    if (had_tick) {
+        gtk_widget_remove_tick_callback(s->box, st->update_tick_id);
+        st->update_tick_id = 0;
+        st->update_tick_widget = NULL;
+    }
+
+    gtk_window_destroy(GTK_WINDOW(s->window));
+
+    // The widgets went with the window; forget them in the shared items.
+    GPtrArray *lists[] = { st->items, st->running_items };
+    for (guint l = 0; l < G_N_ELEMENTS(lists); l++) {
+        for (guint i = 0; lists[l] && i < lists[l]->len; i++) {
+            DockItem *it = g_ptr_array_index(lists[l], i);
+            if (it->widgets->len > s->slot) memset(item_widgets(it, s->slot), 0, sizeof(DockItemWidgets));
+        }
+    }
+
+    g_ptr_array_index(st->docks, s->slot) = NULL;
+    g_object_unref(s->monitor);
+    g_free(s);
+
+    if (had_tick) request_update_frame(st);
+}
+
+static const char *surface_name(GdkMonitor *mon) {
+    const char *connector = gdk_monitor_get_connector(mon);
+    return connector ? connector : "?";
+}
+
+static gboolean monitor_listed(GListModel *mons, GdkMonitor *mon) {
+    guint n = g_list_model_get_n_items(mons);
+    for (guint i = 0; i < n; i++) {
+        GdkMonitor *m = g_list_model_get_item(mons, i);
+        g_object_unref(m);
+        if (m == mon) return TRUE;
+    }
+    return FALSE;
+}
+
+// Adds a dock for each monitor that has none and drops the docks of
+// monitors that went away. Other docks are left alone.
+static void sync_surfaces(AppState *st) {
+    for (guint i = 0; i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (!s || monitor_listed(st->outputs, s->monitor)) continue;
+        g_message("dock: monitor %s removed", surface_name(s->monitor));
+        surface_free(s);
+    }
+
+    guint n = g_list_model_get_n_items(st->outputs);
+    for (guint i = 0; i < n; i++) {
+        GdkMonitor *mon = g_list_model_get_item(st->outputs, i);
+
+        guint slot = st->docks->len;
+        gboolean have = FALSE;
+        for (guint j = st->docks->len; j-- > 0; ) {
+            DockSurface *s = g_ptr_array_index(st->docks, j);
+            if (!s) slot = j;
+            else if (s->monitor == mon) have = TRUE;
+        }
+        if (!have) {
+            if (slot == st->docks->len) g_ptr_array_add(st->docks, NULL);
+            g_ptr_array_index(st->docks, slot) = surface_new(st, mon, slot);
+            g_message("dock: monitor %s added", surface_name(mon));
+        }
+        g_object_unref(mon);
+    }
+}
+
+static void on_outputs_changed(GListModel *mons, guint pos, guint removed, guint added, gpointer data) {
+    (void)mons; (void)pos; (void)removed; (void)added;
+    sync_surfaces(data);
 }
 
 void dock_init(AppState *st) {
-    if (!st || !st->dock_box) return;
+    if (!st || st->docks) return;
 
     // If state_new already loaded config, reuse it; otherwise load it here.
     if (!st->cfg) st->cfg = dock_config_load();
+    st->docks = g_ptr_array_new();
+
+    // Build the shared model first; each dock then only adds widgets.
+    dock_reconcile(st, st->cfg, st->cfg->icon_size);
 
-    // Build dock UI from current cfg without reloading it.
-    dock_build_from_cfg(st, st->cfg);
+    GdkDisplay *dpy = gdk_display_get_default();
+    if (!dpy) return;
+    st->outputs = g_object_ref(gdk_display_get_monitors(dpy));
+    st->outputs_changed_id = g_signal_connect(st->outputs, "items-changed", G_CALLBACK(on_outputs_changed), st);
+    sync_surfaces(st);
 }
 
 void dock_shutdown(AppState *st) {
-    if (!st) return;
+    if (!st || !st->docks) return;
+
+    if (st->outputs) {
+        g_signal_handler_disconnect(st->outputs, st->outputs_changed_id);
+        g_clear_object(&st->outputs);
+    }
+    if (st->update_timer_id) {
+        g_source_remove(st->update_timer_id);
+        st->update_timer_id = 0;
+    }
+    if (st->update_tick_id && st->update_tick_widget) {
+        gtk_widget_remove_tick_callback(st->update_tick_widget, st->update_tick_id);
+        st->update_tick_id = 0;
+        st->update_tick_widget = NULL;
+    }
+    dock_log_stats(st);
 
-    // Optional: clear the UI container (GTK will usually tear down anyway).
-    if (st->dock_box) clear_box(st->dock_box);
+    // Windows first, then the model they show.
+    for (guint i = 0; i < st->docks->len; i++) {
+        DockSurface *s = g_ptr_array_index(st->docks, i);
+        if (s) surface_free(s);
+    }
+    g_clear_pointer(&st->docks, g_ptr_array_unref);
 
-    // Free dock runtime list (DockItem*, match_key, desktop_id, dot pointers).
+    // Free dock runtime list (DockItem*, match_key, desktop_id, widgets).
+    g_clear_pointer(&st->item_index, g_hash_table_destroy);
+    g_clear_pointer(&st->running_items, g_ptr_array_unref);
+    g_clear_pointer(&st->running_aliases, g_hash_table_destroy);
     if (st->items) {
         g_ptr_array_free(st->items, TRUE);
         st->items = NULL;
@@ -0,0 +1,474 @@
+#include "dock_view.h"
+#include "icon_cache.h"
+
+#include <math.h>
+
+// Geometry mirrors the widget dock (style.css: button.icon padding,
+// .dock spacing, .indicator size and margin) so both look alike.
+#define ITEM_PAD_X     8
+#define ITEM_SPACING   8
+#define DOT_GAP        9    // box spacing + indicator margin
+#define DOT_W          5
+#define DOT_W_FOCUSED  12
+#define DOT_H          9
+#define SEP_W          9    // 1px line plus margins
+
+#define MAGNIFY_RADIUS    2.0     // items either side of the pointer that grow
+#define MAGNIFY_TAU_US    60000.0 // time constant of the ease towards the target
+#define MAGNIFY_EPSILON   0.002
+#define OVER_BUDGET_LIMIT 8       // consecutive slow frames before giving up
+
+struct _DockViewItem {
+    GIcon *gicon;
+    char *label;
+    IconCacheEntry *icon;       // acquired lazily for paintable_size/scale
+    int paintable_size;
+    int paintable_scale;
+    PangoLayout *layout;        // label fallback
+    float dot_opacity;
+    gboolean focused;
+    gboolean sep_before;
+    float scale;                // current magnification, eased towards target
+    float target;
+    gpointer data;
+};
+
+struct _DockView {
+    GtkWidget parent_instance;
+
+    GPtrArray *items;           // DockViewItem*, in display order
+    int icon_size;
+    DockViewItem *pressed;
+
+    DockViewActivateFunc activate;
+    gpointer activate_data;
+
+    // Magnification
+    double magnify;             // 1.0 = off
+    gboolean magnify_disabled;  // turned off after sustained over-budget frames
+    double pointer_x;           // -1 when the pointer is outside
+    guint tick_id;
+    gint64 last_frame_us;
+    guint over_budget;
+
+    // Instrumentation: allocations must not move while animating.
+    guint64 layout_passes;
+    guint64 anim_start_passes;
+    guint anim_frames;
+    gint64 anim_worst_us;
+};
+
+G_DEFINE_FINAL_TYPE(DockView, dock_view, GTK_TYPE_WIDGET)
+
+static void item_free(gpointer p) {
+    DockViewItem *it = p;
+    if (!it) return;
+    g_clear_object(&it->gicon);
+    g_clear_pointer(&it->icon, icon_cache_release);
+    g_clear_object(&it->layout);
+    g_free(it->label);
+    g_free(it);
+}
+
+static int item_width(DockView *v, const DockViewItem *it) {
+    return v->icon_size + 2 * ITEM_PAD_X + (it->sep_before ? SEP_W : 0);
+}
+
+/* Layout */
+
+static void dock_view_measure(GtkWidget *w, GtkOrientation orientation, int for_size,
+                              int *minimum, int *natural, int *min_baseline, int *nat_baseline) {
+    (void)for_size;
+    DockView *v = DOCK_VIEW(w);
+
+    int size = 0;
+    if (orientation == GTK_ORIENTATION_HORIZONTAL) {
+        for (guint i = 0; i < v->items->len; i++) {
+            size += item_width(v, g_ptr_array_index(v->items, i));
+        }
+        if (v->items->len > 1) size += ITEM_SPACING * (int)(v->items->len - 1);
+    } else {
+        size = v->icon_size + DOT_GAP + DOT_H;
+    }
+
+    *minimum = *natural = size;
+    *min_baseline = *nat_baseline = -1;
+}
+
+static void dock_view_size_allocate(GtkWidget *w, int width, int height, int baseline) {
+    (void)width; (void)height; (void)baseline;
+    DOCK_VIEW(w)->layout_passes++;
+}
+
+static DockViewItem *item_at(DockView *v, double x, double y) {
+    if (y < 0 || y > v->icon_size + DOT_GAP + DOT_H) return NULL;
+
+    double left = 0;
+    for (guint i = 0; i < v->items->len; i++) {
+        DockViewItem *it = g_ptr_array_index(v->items, i);
+        int w = item_width(v, it);
+        double start = left + (it->sep_before ? SEP_W : 0);
+        if (x >= start && x < left + w) return it;
+        left += w + ITEM_SPACING;
+    }
+    return NULL;
+}
+
+/* Drawing */
+
+// Shared with the other docks and the searcher through the icon cache.
+static void ensure_paintable(DockView *v, DockViewItem *it) {
+    int scale = gtk_widget_get_scale_factor(GTK_WIDGET(v));
+    if (it->icon && it->paintable_size == v->icon_size && it->paintable_scale == scale) return;
+
+    g_clear_pointer(&it->icon, icon_cache_release);
+    it->icon = icon_cache_acquire(it->gicon, v->icon_size, scale);
+    it->paintable_size = v->icon_size;
+    it->paintable_scale = scale;
+}
+
+static void draw_label(DockView *v, GtkSnapshot *s, DockViewItem *it, float x) {
+    if (!it->layout) {
+        it->layout = gtk_widget_create_pango_layout(GTK_WIDGET(v), it->label);
+        pango_layout_set_width(it->layout, v->icon_size * PANGO_SCALE);
+        pango_layout_set_ellipsize(it->layout, PANGO_ELLIPSIZE_END);
+        pango_layout_set_alignment(it->layout, PANGO_ALIGN_CENTER);
+    }
+
+    int lw, lh;
+    pango_layout_get_pixel_size(it->layout, &lw, &lh);
+
+    GdkRGBA fg;
+    gtk_widget_get_color(GTK_WIDGET(v), &fg);
+
+    gtk_snapshot_save(s);
+    gtk_snapshot_translate(s, &GRAPHENE_POINT_INIT(x, (v->icon_size - lh) / 2.0f));
+    gtk_snapshot_append_layout(s, it->layout, &fg);
+    gtk_snapshot_restore(s);
+}
+
+static void draw_dot(GtkSnapshot *s, const DockViewItem *it, float cx, float y) {
+    if (it->dot_opacity <= 0.0f) return;
+
+    float w = it->focused ? DOT_W_FOCUSED : DOT_W;
+    GskRoundedRect r;
+    gsk_rounded_rect_init_from_rect(&r, &GRAPHENE_RECT_INIT(cx - w / 2.0f, y, w, DOT_H), DOT_W / 2.0f);
+
+    GdkRGBA c = { 0.933f, 0.933f, 0.933f, (it->focused ? 0.9f : 0.5f) * it->dot_opacity };
+    gtk_snapshot_push_rounded_clip(s, &r);
+    gtk_snapshot_append_color(s, &c, &r.bounds);
+    gtk_snapshot_pop(s);
+}
+
+static void dock_view_snapshot(GtkWidget *w, GtkSnapshot *s) {
+    DockView *v = DOCK_VIEW(w);
+    float size = (float)v->icon_size;
+    float dot_y = size + DOT_GAP;
+    float left = 0;
+
+    for (guint i = 0; i < v->items->len; i++) {
+        DockViewItem *it = g_ptr_array_index(v->items, i);
+
+        if (it->sep_before) {
+            GdkRGBA c = { 0.933f, 0.933f, 0.933f, 0.25f };
+            gtk_snapshot_append_color(s, &c, &GRAPHENE_RECT_INIT(left + SEP_W / 2.0f, 4, 1, size - 8));
+            left += SEP_W;
+        }
+
+        float x = left + ITEM_PAD_X;
+        gtk_snapshot_save(s);
+        if (it->scale != 1.0f) {
+            // Grow from the bottom centre, above the allocation: the
+            // layout never sees it.
+            gtk_snapshot_translate(s, &GRAPHENE_POINT_INIT(x + size / 2.0f, size));
+            gtk_snapshot_scale(s, it->scale, it->scale);
+            gtk_snapshot_translate(s, &GRAPHENE_POINT_INIT(-size / 2.0f, -size));
+        } else {
+            gtk_snapshot_translate(s, &GRAPHENE_POINT_INIT(x, 0));
+        }
+        if (it->gicon) {
+            ensure_paintable(v, it);
+            gdk_paintable_snapshot(icon_cache_entry_paintable(it->icon), s, size, size);
+        } else {
+            draw_label(v, s, it, 0);
+        }
+        gtk_snapshot_restore(s);
+
+        draw_dot(s, it, x + size / 2.0f, dot_y);
+        left = x + size + ITEM_PAD_X + ITEM_SPACING;
+    }
+}
+
+/* Magnification */
+
+// Icons grow upward into whatever the surface has above the view (the top
+// padding of .dock); past that they would be cut off at the window edge.
+static double magnify_limit(DockView *v) {
+    GtkWidget *w = GTK_WIDGET(v);
+    GtkRoot *root = gtk_widget_get_root(w);
+    graphene_point_t top;
+    if (!root || v->icon_size <= 0
+        || !gtk_widget_compute_point(w, GTK_WIDGET(root), &GRAPHENE_POINT_INIT(0, 0), &top)) {
+        return v->magnify;
+    }
+    return MAX(1.0, (v->icon_size + top.y) / v->icon_size);
+}
+
+static void update_targets(DockView *v) {
+    gboolean on = v->magnify > 1.0 && !v->magnify_disabled && v->pointer_x >= 0;
+    double magnify = on ? MIN(v->magnify, magnify_limit(v)) : 1.0;
+    double pitch = v->icon_size + 2 * ITEM_PAD_X + ITEM_SPACING;
+    double left = 0;
+
+    for (guint i = 0; i < v->items->len; i++) {
+        DockViewItem *it = g_ptr_array_index(v->items, i);
+        int w = item_width(v, it);
+        double center = left + (it->sep_before ? SEP_W : 0) + (v->icon_size + 2 * ITEM_PAD_X) / 2.0;
+        left += w + ITEM_SPACING;
+
+        double t = on ? 1.0 - fabs(v->pointer_x - center) / (pitch * MAGNIFY_RADIUS) : 0.0;
+        if (t < 0) t = 0;
+        t = t * t * (3 - 2 * t);   // smoothstep
+        it->target = (float)(1.0 + (magnify - 1.0) * t);
+    }
+}
+
+static void end_animation(DockView *v) {
+    g_debug("dock view: magnify animation, %u frames, %" G_GUINT64_FORMAT
+            " layout passes, worst frame %.1f ms",
+            v->anim_frames, v->layout_passes - v->anim_start_passes, v->anim_worst_us / 1000.0);
+}
+
+static gboolean magnify_tick(GtkWidget *w, GdkFrameClock *clock, gpointer data) {
+    (void)data;
+    DockView *v = DOCK_VIEW(w);
+
+    gint64 now = gdk_frame_clock_get_frame_time(clock);
+    gint64 dt = v->last_frame_us ? now - v->last_frame_us : 0;
+    v->last_frame_us = now;
+
+    // Budget: one refresh interval plus half again for jitter.
+    gint64 refresh = 0;
+    gdk_frame_clock_get_refresh_info(clock, now, &refresh, NULL);
+    if (refresh <= 0) refresh = 16667;
+
+    if (dt > 0) {
+        v->anim_frames++;
+        if (dt > v->anim_worst_us) v->anim_worst_us = dt;
+
+        if (dt > refresh + refresh / 2) v->over_budget++;
+        else v->over_budget = 0;
+
+        if (v->over_budget >= OVER_BUDGET_LIMIT && !v->magnify_disabled) {
+            g_message("dock view: magnification disabled, frames took %.1f ms (budget %.1f ms)",
+                      dt / 1000.0, (refresh + refresh / 2) / 1000.0);
+            v->magnify_disabled = TRUE;
+            update_targets(v);
+        }
+    }
+
+    // Frame-rate independent ease; snap straight to the target once disabled.
+    double k = v->magnify_disabled ? 1.0 : 1.0 - exp(-(double)dt / MAGNIFY_TAU_US);
+    gboolean settled = TRUE;
+    for (guint i = 0; i < v->items->len; i++) {
+        DockViewItem *it = g_ptr_array_index(v->items, i);
+        it->scale += (float)((it->target - it->scale) * k);
+        if (fabsf(it->target - it->scale) < MAGNIFY_EPSILON) it->scale = it->target;
+        else settled = FALSE;
+    }
+    gtk_widget_queue_draw(w);
+
+    if (!settled) return G_SOURCE_CONTINUE;
+
+    end_animation(v);
+    v->tick_id = 0;
+    return G_SOURCE_REMOVE;
+}
+
+static void animate(DockView *v) {
+    update_targets(v);
+    if (v->tick_id) return;
+
+    gboolean moving = FALSE;
+    for (guint i = 0; i < v->items->len && !moving; i++) {
+        DockViewItem *it = g_ptr_array_index(v->items, i);
+        moving = it->scale != it->target;
+    }
+    if (!moving) return;
+
+    v->last_frame_us = 0;
+    v->over_budget = 0;
+    v->anim_frames = 0;
+    v->anim_worst_us = 0;
+    v->anim_start_passes = v->layout_passes;
+    v->tick_id = gtk_widget_add_tick_callback(GTK_WIDGET(v), magnify_tick, NULL, NULL);
+}
+
+void dock_view_hover(DockView *v, double x) {
+    if (x >= 0 && (v->magnify <= 1.0 || v->magnify_disabled)) return;
+    v->pointer_x = x;
+    if (v->magnify > 1.0) animate(v);
+}
+
+static void on_motion(GtkEventControllerMotion *m, double x, double y, gpointer data) {
+    (void)m; (void)y;
+    dock_view_hover(data, x);
+}
+
+static void on_leave(GtkEventControllerMotion *m, gpointer data) {
+    (void)m;
+    dock_view_hover(data, -1);
+}
+
+/* Input */
+
+static void on_pressed(GtkGestureClick *g, int n, double x, double y, gpointer data) {
+    (void)g; (void)n;
+    DockView *v = data;
+    v->pressed = item_at(v, x, y);
+}
+
+static void on_released(GtkGestureClick *g, int n, double x, double y, gpointer data) {
+    (void)n;
+    DockView *v = data;
+    DockViewItem *it = item_at(v, x, y);
+
+    // Like a button: only fires if released over the item it was pressed on.
+    if (it && it == v->pressed && v->activate) {
+        v->activate(it->data, gtk_gesture_single_get_current_button(GTK_GESTURE_SINGLE(g)), v->activate_data);
+    }
+    v->pressed = NULL;
+}
+
+/* GObject */
+
+static void dock_view_dispose(GObject *o) {
+    DockView *v = DOCK_VIEW(o);
+    if (v->tick_id) {
+        gtk_widget_remove_tick_callback(GTK_WIDGET(v), v->tick_id);
+        v->tick_id = 0;
+    }
+    g_clear_pointer(&v->items, g_ptr_array_unref);
+    G_OBJECT_CLASS(dock_view_parent_class)->dispose(o);
+}
+
+static void dock_view_class_init(DockViewClass *klass) {
+    GObjectClass *oc = G_OBJECT_CLASS(klass);
+    GtkWidgetClass *wc = GTK_WIDGET_CLASS(klass);
+
+    oc->dispose = dock_view_dispose;
+    wc->measure = dock_view_measure;
+    wc->size_allocate = dock_view_size_allocate;
+    wc->snapshot = dock_view_snapshot;
+    gtk_widget_class_set_css_name(wc, "dockview");
+}
+
+static void dock_view_init(DockView *v) {
+    v->items = g_ptr_array_new_with_free_func(item_free);
+    v->icon_size = 32;
+    v->magnify = 1.0;
+    v->pointer_x = -1;
+
+    GtkEventController *motion = gtk_event_controller_motion_new();
+    g_signal_connect(motion, "enter", G_CALLBACK(on_motion), v);
+    g_signal_connect(motion, "motion", G_CALLBACK(on_motion), v);
+    g_signal_connect(motion, "leave", G_CALLBACK(on_leave), v);
+    gtk_widget_add_controller(GTK_WIDGET(v), motion);
+
+    GtkGesture *click = gtk_gesture_click_new();
+    gtk_gesture_single_set_button(GTK_GESTURE_SINGLE(click), 0);   // any button
+    g_signal_connect(click, "pressed", G_CALLBACK(on_pressed), v);
+    g_signal_connect(click, "released", G_CALLBACK(on_released), v);
+    gtk_widget_add_controller(GTK_WIDGET(v), GTK_EVENT_CONTROLLER(click));
+}
+
+/* API */
+
+GtkWidget *dock_view_new(int icon_size) {
+    DockView *v = g_object_new(DOCK_TYPE_VIEW, NULL);
+    v->icon_size = icon_size;
+    return GTK_WIDGET(v);
+}
+
+void dock_view_set_activate_func(DockView *v, DockViewActivateFunc func, gpointer user_data) {
+    v->activate = func;
+    v->activate_data = user_data;
+}
+
+void dock_view_set_magnify(DockView *v, double factor) {
+    v->magnify = factor;
+    v->magnify_disabled = FALSE;   // a config change gets a fresh chance
+    animate(v);
+}
+
+void dock_view_set_icon_size(DockView *v, int icon_size) {
+    if (v->icon_size == icon_size) return;
+    v->icon_size = icon_size;
+
+    // Label layouts were sized for the old width.
+    for (guint i = 0; i < v->items->len; i++) {
+        g_clear_object(&((DockViewItem*)g_ptr_array_index(v->items, i))->layout);
+    }
+    gtk_widget_queue_resize(GTK_WIDGET(v));
+}
+
+static guint index_of(DockView *v, DockViewItem *it) {
+    guint i = 0;
+    g_ptr_array_find(v->items, it, &i);
+    return i;
+}
+
+DockViewItem *dock_view_insert_after(DockView *v, DockViewItem *prev, GIcon *gicon,
+                                     const char *label, gpointer item_data) {
+    DockViewItem *it = g_new0(DockViewItem, 1);
+    it->gicon = gicon ? g_object_ref(gicon) : NULL;
+    it->label = g_strdup(label ? label : "");
+    it->data = item_data;
+    it->scale = it->target = 1.0f;
+
+    guint at = prev ? index_of(v, prev) + 1 : 0;
+    g_ptr_array_insert(v->items, (gint)at, it);
+    gtk_widget_queue_resize(GTK_WIDGET(v));
+    return it;
+}
+
+DockViewItem *dock_view_append(DockView *v, GIcon *gicon, const char *label, gpointer item_data) {
+    DockViewItem *last = v->items->len ? g_ptr_array_index(v->items, v->items->len - 1) : NULL;
+    return dock_view_insert_after(v, last, gicon, label, item_data);
+}
+
+void dock_view_remove(DockView *v, DockViewItem *it) {
+    if (v->pressed == it) v->pressed = NULL;
+    g_ptr_array_remove(v->items, it);   // frees it
+    gtk_widget_queue_resize(GTK_WIDGET(v));
+}
+
+DockViewItem *dock_view_get_prev(DockView *v, DockViewItem *it) {
+    guint i = index_of(v, it);
+    return i > 0 ? g_ptr_array_index(v->items, i - 1) : NULL;
+}
+
+void dock_view_move_after(DockView *v, DockViewItem *it, DockViewItem *prev) {
+    g_ptr_array_steal_index(v->items, index_of(v, it));
+    guint at = prev ? index_of(v, prev) + 1 : 0;
+    g_ptr_array_insert(v->items, (gint)at, it);
+    gtk_widget_queue_draw(GTK_WIDGET(v));
+}
+
+void dock_view_set_dot(DockView *v, DockViewItem *it, double opacity) {
+    if (it->dot_opacity == (float)opacity) return;
+    it->dot_opacity = (float)opacity;
+    gtk_widget_queue_draw(GTK_WIDGET(v));
+}
+
+void dock_view_set_focused(DockView *v, DockViewItem *it, gboolean focused) {
+    if (it->focused == focused) return;
+    it->focused = focused;
+    gtk_widget_queue_draw(GTK_WIDGET(v));
+}
+
+void dock_view_set_separator_before(DockView *v, DockViewItem *it, gboolean sep) {
+    if (it->sep_before == sep) return;
+    it->sep_before = sep;
+    gtk_widget_queue_resize(GTK_WIDGET(v));
+}
@@ -0,0 +1,59 @@
+#include "event_queue.h"
+
+#include <string.h>
+
+#define MASK (EVENT_QUEUE_SLOTS - 1)
+
+EventQueue *event_queue_new(void) {
+    return g_new0(EventQueue, 1);
+}
+
+void event_queue_free(EventQueue *q) {
+    g_free(q);
+}
+
+gboolean event_queue_push(EventQueue *q, guint bits, guint kind, gint64 time_us,
+                          const char *data, gsize len) {
+    guint tail = (guint)g_atomic_int_get(&q->tail);
+    guint head = (guint)g_atomic_int_get(&q->head);
+
+    if (tail - head >= EVENT_QUEUE_SLOTS) {
+        g_atomic_int_set(&q->overflowed, 1);
+        return FALSE;
+    }
+
+    if (len > EVENT_LINE_MAX - 1) {
+        len = EVENT_LINE_MAX - 1;
+        // Don't split a UTF-8 sequence.
+        while (len > 0 && ((guchar)data[len] & 0xC0) == 0x80) len--;
+    }
+
+    EventSlot *s = &q->slots[tail & MASK];
+    s->bits = bits;
+    s->kind = kind;
+    s->time_us = time_us;
+    s->len = (guint)len;
+    memcpy(s->data, data, len);
+    s->data[len] = '\0';
+
+    // Publishes the slot contents (g_atomic_* are full barriers).
+    g_atomic_int_set(&q->tail, (gint)(tail + 1));
+    return TRUE;
+}
+
+const EventSlot *event_queue_peek(EventQueue *q) {
+    guint head = (guint)g_atomic_int_get(&q->head);
+    guint tail = (guint)g_atomic_int_get(&q->tail);
+
+    if (head == tail) return NULL;
+    return &q->slots[head & MASK];
+}
+
+void event_queue_pop(EventQueue *q) {
+    guint head = (guint)g_atomic_int_get(&q->head);
+    g_atomic_int_set(&q->head, (gint)(head + 1));
+}
+
+gboolean event_queue_take_overflow(EventQueue *q) {
+    return g_atomic_int_compare_and_exchange(&q->overflowed, 1, 0);
+}
@@ -1,72 +1,198 @@
 #define _GNU_SOURCE
 #include "hypr.h"
-#include "jsmn.h"
-#include <stdio.h>
+#include "hypr_ipc.h"
+#include "json_scan.h"
+#include "intern.h"
 #include <glib.h>
 #include <string.h>
 
-static char* read_cmd_all(const char *cmd) {
-	FILE *fp = popen(cmd, "r");
-	if (!fp) return NULL;
+// Keys pulled out of each j/clients object, in HyprClient field order.
+enum { K_ADDRESS, K_CLASS, K_TITLE, K_WS_ID, K_WS_NAME, K_MONITOR, K_FOCUS, K_COUNT };
 
-	GString *buf = g_string_new(NULL);
-	char tmp[4096];
-	while (fgets(tmp, sizeof(tmp), fp)) g_string_append(buf, tmp);
+static const char *const client_keys[K_COUNT] = {
+	[K_ADDRESS] = "address",
+	[K_CLASS]   = "class",
+	[K_TITLE]   = "title",
+	[K_WS_ID]   = "workspace.id",
+	[K_WS_NAME] = "workspace.name",
+	[K_MONITOR] = "monitor",
+	[K_FOCUS]   = "focusHistoryID",
+};
 
-	int rc = pclose(fp);
-	(void)rc;
+enum { W_ID, W_NAME, W_MONITOR, W_COUNT };
 
-	return g_string_free(buf, FALSE);
+static const char *const workspace_keys[W_COUNT] = {
+	[W_ID]      = "id",
+	[W_NAME]    = "name",
+	[W_MONITOR] = "monitorID",
+};
+
+enum { M_ID, M_NAME, M_FOCUSED, M_COUNT };
+
+static const char *const monitor_keys[M_COUNT] = {
+	[M_ID]      = "id",
+	[M_NAME]    = "name",
+	[M_FOCUSED] = "focused",
+};
+
+// Stripped and lowercased straight from the reply: no allocation for a
+// class the pool has seen before, which is nearly every one after startup.
+static const char *value_intern_class(const JsonScanValue *v) {
+	if (v->type != JSON_SCAN_STRING) return intern("");
+	if (v->escaped) {
+		char *s = g_malloc(v->len + 1);
+		s[json_unescape(v->ptr, v->len, s)] = '\0';
+		const char *k = intern_lower(g_strstrip(s));
+		g_free(s);
+		return k;
+	}
+
+	const char *p = v->ptr, *end = v->ptr + v->len;
+	while (p < end && g_ascii_isspace(*p)) p++;
+	while (end > p && g_ascii_isspace(end[-1])) end--;
+	return intern_lower_len(p, (gsize)(end - p));
+}
+
+static char* value_strdup(const JsonScanValue *v) {
+	if (v->type != JSON_SCAN_STRING) return g_strdup("");
+	if (!v->escaped) return g_strndup(v->ptr, v->len);
+
+	char *s = g_malloc(v->len + 1);
+	s[json_unescape(v->ptr, v->len, s)] = '\0';
+	return s;
+}
+
+void hypr_client_free(gpointer p) {
+    HyprClient *c = (HyprClient*)p;
+    if (!c) return;
+    g_free(c->title);
+    g_free(c->workspace);
+    g_free(c);
 }
 
-static gboolean token_streq(const char *json, const jsmntok_t *t, const char *s) {
-	int len = t->end - t->start;
-	return (
-			t->type == JSMN_STRING &&
-			(int)strlen(s) == len &&
-			strncmp(json + t->start, s, len) == 0
-	);
+void hypr_workspace_free(gpointer p) {
+    HyprWorkspace *w = (HyprWorkspace*)p;
+    if (!w) return;
+    g_free(w->name);
+    g_free(w);
 }
 
-static char* token_strdup(const char *json, const jsmntok_t *t) {
-	int len = t->end - t->start;
-	return g_strndup(json + t->start, len);
+void hypr_monitor_free(gpointer p) {
+    HyprMonitor *m = (HyprMonitor*)p;
+    if (!m) return;
+    g_free(m->name);
+    g_free(m);
 }
 
-GHashTable* hypr_get_running_class_counts(void) {
-    char *json = read_cmd_all("hyprctl -j clients");
-    GHashTable *m = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-    if (!json) return m;
+// Addresses are short hex strings ("0x55d0..."): parse without allocating.
+static guint64 value_address(const JsonScanValue *v) {
+    if (v->type != JSON_SCAN_STRING) return 0;
 
-    jsmn_parser p;
-    jsmn_init(&p);
+    char addr[32];
+    gsize n = MIN(v->len, sizeof(addr) - 1);
+    memcpy(addr, v->ptr, n);
+    addr[n] = '\0';
+    return g_ascii_strtoull(addr, NULL, 16);
+}
+
+static void on_client_object(const JsonScanValue *v, void *user) {
+    GPtrArray *out = user;
+
+    guint64 address = value_address(&v[K_ADDRESS]);
+    if (!address) return;
 
-    int cap = 8192;
-    jsmntok_t *tok = g_new0(jsmntok_t, cap);
-    int n = jsmn_parse(&p, json, (int)strlen(json), tok, cap);
+    HyprClient *c = g_new0(HyprClient, 1);
+    c->address = address;
 
-    if (n >= 0) {
-        for (int i = 0; i < n - 1; i++) {
-            if (token_streq(json, &tok[i], "class") && tok[i+1].type == JSMN_STRING) {
-                char *cls = token_strdup(json, &tok[i+1]);
-                g_strstrip(cls);
+    c->cls = value_intern_class(&v[K_CLASS]);
 
-                char *lower = g_ascii_strdown(cls, -1);
-                g_free(cls);
+    c->title = value_strdup(&v[K_TITLE]);
+    c->workspace = value_strdup(&v[K_WS_NAME]);
+    c->workspace_id = (int)json_scan_int(&v[K_WS_ID], 0);
+    c->monitor = (int)json_scan_int(&v[K_MONITOR], -1);
+    c->focus_history = (int)json_scan_int(&v[K_FOCUS], -1);
+
+    g_ptr_array_add(out, c);
+}
 
-                if (lower && *lower) {
-                    gpointer oldv = g_hash_table_lookup(m, lower);
-                    int oldc = oldv ? GPOINTER_TO_INT(oldv) : 0;
-                    g_hash_table_insert(m, lower, GINT_TO_POINTER(oldc + 1));
-                } else {
-                    g_free(lower);
-                }
-                i++; // skip value token
-            }
-        }
+GPtrArray* hypr_parse_clients(const char *json, gsize len) {
+    GPtrArray *out = g_ptr_array_new_with_free_func(hypr_client_free);
+    if (!json) return out;
+
+    long n = json_scan_objects(json, len, client_keys, K_COUNT, on_client_object, out);
+    if (n < 0) {
+        // Keep whatever was complete before the error rather than going dark.
+        g_warning("malformed j/clients reply (%u clients parsed)", out->len);
     }
+    return out;
+}
 
-    g_free(tok);
+GPtrArray* hypr_get_clients(void) {
+    char *json = hypr_ipc_request("j/clients");
+    GPtrArray *out = hypr_parse_clients(json, json ? strlen(json) : 0);
     g_free(json);
-    return m;
+    return out;
+}
+
+static void on_workspace_object(const JsonScanValue *v, void *user) {
+    GPtrArray *out = user;
+    if (v[W_ID].type != JSON_SCAN_PRIMITIVE) return;
+
+    HyprWorkspace *w = g_new0(HyprWorkspace, 1);
+    w->id = (int)json_scan_int(&v[W_ID], 0);
+    w->name = value_strdup(&v[W_NAME]);
+    w->monitor = (int)json_scan_int(&v[W_MONITOR], -1);
+    g_ptr_array_add(out, w);
+}
+
+GPtrArray* hypr_parse_workspaces(const char *json, gsize len) {
+    GPtrArray *out = g_ptr_array_new_with_free_func(hypr_workspace_free);
+    if (json && json_scan_objects(json, len, workspace_keys, W_COUNT, on_workspace_object, out) < 0) {
+        g_warning("malformed j/workspaces reply");
+    }
+    return out;
+}
+
+static void on_monitor_object(const JsonScanValue *v, void *user) {
+    GPtrArray *out = user;
+    if (v[M_ID].type != JSON_SCAN_PRIMITIVE) return;
+
+    HyprMonitor *m = g_new0(HyprMonitor, 1);
+    m->id = (int)json_scan_int(&v[M_ID], 0);
+    m->name = value_strdup(&v[M_NAME]);
+    m->focused = v[M_FOCUSED].type == JSON_SCAN_PRIMITIVE && v[M_FOCUSED].len == 4
+        && memcmp(v[M_FOCUSED].ptr, "true", 4) == 0;
+    g_ptr_array_add(out, m);
+}
+
+GPtrArray* hypr_parse_monitors(const char *json, gsize len) {
+    GPtrArray *out = g_ptr_array_new_with_free_func(hypr_monitor_free);
+    if (json && json_scan_objects(json, len, monitor_keys, M_COUNT, on_monitor_object, out) < 0) {
+        g_warning("malformed j/monitors reply");
+    }
+    return out;
+}
+
+static void on_active_object(const JsonScanValue *v, void *user) {
+    *(guint64*)user = value_address(&v[0]);
+}
+
+guint64 hypr_parse_active_address(const char *json, gsize len) {
+    static const char *const keys[] = { "address" };
+    guint64 addr = 0;
+    if (json) json_scan_objects(json, len, keys, 1, on_active_object, &addr);
+    return addr;
+}
+
+gboolean hypr_focus_window(guint64 address) {
+    if (!address) return FALSE;
+
+    char req[64];
+    g_snprintf(req, sizeof(req), "dispatch focuswindow address:0x%" G_GINT64_MODIFIER "x", address);
+
+    char *reply = hypr_ipc_request(req);
+    gboolean ok = reply && g_str_has_prefix(reply, "ok");
+    if (!ok) g_warning("focuswindow 0x%" G_GINT64_MODIFIER "x failed: %s", address, reply ? reply : "no reply");
+    g_free(reply);
+    return ok;
 }
@@ -2,103 +2,200 @@
 
 #include <glib.h>
 #include <errno.h>
-#include <dirent.h>
 #include <string.h>
 #include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 
 #include "state.h"
 #include "dock.h"
+#include "hypr_ipc.h"
+#include "poller.h"
+#include "line_framer.h"
+#include "event_queue.h"
+#include "launch_stats.h"
+
+typedef struct {
+    const char *name;
+    guint bits;
+    WinEvent kind;      // what the main loop applies to the window table
+} HyprEventClass;
+
+// Every socket2 event we know of. Where Hyprland emits both a v1 and a v2
+// form of the same event, only the richer v2 form is acted on; windowtitle
+// is the exception, kept for releases that predate windowtitlev2.
+static const HyprEventClass event_table[] = {
+    { "openwindow",          HYPR_DIRTY_RUNNING,   WIN_EVENT_OPEN_WINDOW },
+    { "closewindow",         HYPR_DIRTY_RUNNING,   WIN_EVENT_CLOSE_WINDOW },
+    { "movewindow",          0 },
+    { "movewindowv2",        HYPR_DIRTY_WORKSPACE, WIN_EVENT_MOVE_WINDOW },
+    { "windowtitle",         HYPR_DIRTY_TITLE,     WIN_EVENT_WINDOW_TITLE_V1 },
+    { "windowtitlev2",       HYPR_DIRTY_TITLE,     WIN_EVENT_WINDOW_TITLE },
+    { "activewindow",        0 },
+    { "activewindowv2",      HYPR_DIRTY_ACTIVE,    WIN_EVENT_ACTIVE_WINDOW },
+    { "workspace",           0 },
+    { "workspacev2",         0 },   // focus only; the dock does not care
+    { "createworkspace",     0 },
+    { "createworkspacev2",   HYPR_DIRTY_WORKSPACE, WIN_EVENT_CREATE_WORKSPACE },
+    { "destroyworkspace",    0 },
+    { "destroyworkspacev2",  HYPR_DIRTY_WORKSPACE, WIN_EVENT_DESTROY_WORKSPACE },
+    { "renameworkspace",     HYPR_DIRTY_WORKSPACE, WIN_EVENT_RENAME_WORKSPACE },
+    { "moveworkspace",       0 },
+    { "moveworkspacev2",     HYPR_DIRTY_MONITOR,   WIN_EVENT_MOVE_WORKSPACE },
+    { "activespecial",       0 },
+    { "activespecialv2",     0 },
+    { "focusedmon",          0 },
+    { "focusedmonv2",        HYPR_DIRTY_MONITOR,   WIN_EVENT_FOCUSED_MONITOR },
+    { "monitoradded",        0 },
+    { "monitoraddedv2",      HYPR_DIRTY_MONITOR,   WIN_EVENT_MONITOR_ADDED },
+    { "monitorremoved",      0 },
+    { "monitorremovedv2",    HYPR_DIRTY_MONITOR,   WIN_EVENT_MONITOR_REMOVED },
+    { "submap",              0 },
+    { "fullscreen",          0 },
+    { "changefloatingmode",  0 },
+    { "urgent",              0 },
+    { "minimized",           0 },
+    { "pin",                 0 },
+    { "togglegroup",         0 },
+    { "moveintogroup",       0 },
+    { "moveoutofgroup",      0 },
+    { "lockgroups",          0 },
+    { "ignoregrouplock",     0 },
+    { "screencast",          0 },
+    { "bell",                0 },
+    { "configreloaded",      0 },
+};
+
+// Bits the main loop currently does work for; everything else is dropped.
+#define HYPR_DIRTY_HANDLED (HYPR_DIRTY_RUNNING | HYPR_DIRTY_ACTIVE | HYPR_DIRTY_WORKSPACE | \
+                            HYPR_DIRTY_MONITOR | HYPR_DIRTY_TITLE)
+
+// Looks the event name up once; *data_off is where the data after ">>" starts.
+static const HyprEventClass *classify_event(const char *line, gsize len, gsize *data_off) {
+    const char *sep = memchr(line, '>', len);
+    if (!sep || (gsize)(sep - line) + 1 >= len || sep[1] != '>') return NULL;
+
+    gsize name_len = (gsize)(sep - line);
+    for (guint i = 0; i < G_N_ELEMENTS(event_table); i++) {
+        const char *name = event_table[i].name;
+        if (strncmp(name, line, name_len) == 0 && name[name_len] == '\0') {
+            *data_off = name_len + 2;
+            return &event_table[i];
+        }
+    }
+    return NULL;
+}
+
+#define RESYNC_RETRY_MS 1000
 
-static gboolean add_poll_source_cb(gpointer data) {
+static gboolean resync_retry_cb(gpointer data) {
     AppState *st = data;
-    if (!st) return G_SOURCE_REMOVE;
+    st->resync_retry_id = 0;
 
-    if (st->poll_id == 0) {
-        st->poll_id = g_timeout_add_seconds(1, (GSourceFunc)dock_refresh_running, st);
-    }
+    // resync_needed is still set, so the refresh tries again.
+    if (st->refresh_source) g_source_set_ready_time(st->refresh_source, 0);
     return G_SOURCE_REMOVE;
 }
 
-static void ensure_polling_fallback(AppState *st) {
-    if (!st) return;
-    // Always add sources on the main context.
-    g_main_context_invoke(NULL, add_poll_source_cb, st);
+// The request socket failed: keep the old table and try again shortly.
+static void schedule_resync_retry(AppState *st) {
+    if (st->resync_retry_id) return;
+    g_debug("window resync failed; retrying in %d ms", RESYNC_RETRY_MS);
+    st->resync_retry_id = g_timeout_add(RESYNC_RETRY_MS, resync_retry_cb, st);
 }
 
 static gboolean refresh_idle_cb(gpointer data) {
     AppState *st = data;
-    if (!st) return G_SOURCE_REMOVE;
+    if (!st) return G_SOURCE_CONTINUE;
 
-    st->refresh_idle_id = 0;
     g_atomic_int_set(&st->refresh_pending, 0);
 
-    if (!g_atomic_int_get(&st->stop_requested)) {
-        dock_refresh_running(st);
+    if (g_atomic_int_get(&st->stop_requested)) return G_SOURCE_CONTINUE;
+
+    // Polling only runs while the event socket is down.
+    gboolean want_poll = g_atomic_int_get(&st->want_polling);
+    if (want_poll) poller_start(st);
+    else poller_stop(st);
+
+    gboolean changed = FALSE;
+
+    // Lines were dropped on a full queue: deltas alone can't be trusted.
+    if (event_queue_take_overflow(st->events)) {
+        g_atomic_int_set(&st->resync_requested, 1);
     }
-    return G_SOURCE_REMOVE;
-}
 
-static void schedule_refresh(AppState *st) {
-    if (!st) return;
-    if (g_atomic_int_get(&st->stop_requested)) return;
+    // Drain the whole batch; the producer only wakes us once per read().
+    // Each slot carries the kind the event thread classified it as; the
+    // name is not looked at again here.
+    const EventSlot *ev;
+    while ((ev = event_queue_peek(st->events))) {
+        if (ev->kind == WIN_EVENT_OPEN_WINDOW) launch_stats_note_open(st->launches, ev->data, ev->time_us);
+        if (wintable_apply_event(st->windows, ev->kind, ev->data)) changed = TRUE;
+        event_queue_pop(st->events);
+    }
 
-    if (!g_atomic_int_compare_and_exchange(&st->refresh_pending, 0, 1)) return;
+    // Startup/reconnect: rebuild the table once, then apply deltas on top.
+    gboolean resync = g_atomic_int_compare_and_exchange(&st->resync_requested, 1, 0);
+    if (resync || st->windows->resync_needed) {
+        if (wintable_resync(st->windows)) changed = TRUE;
+        else schedule_resync_retry(st);
+    }
 
-    // Track the idle id so stop() can remove it if needed.
-    st->refresh_idle_id = g_idle_add((GSourceFunc)refresh_idle_cb, st);
+    // wintable_apply_event() only reports changes the dock shows (counts per
+    // class and monitor, focused class); titles just keep the table current.
+    if (changed) dock_schedule_update(st);
+    return G_SOURCE_CONTINUE;
 }
 
-static char *find_hypr_socket2_path(void) {
-    const char *xdg = g_getenv("XDG_RUNTIME_DIR");
-    if (!xdg) return NULL;
+// The refresh source lives as long as the event thread and is only ever
+// created, attached and destroyed on the main thread. It stays asleep
+// (ready time -1) until the event thread wakes it; dispatching puts it
+// back to sleep before the callback runs, so a wakeup that races with the
+// callback is not lost.
+static gboolean refresh_source_dispatch(GSource *src, GSourceFunc cb, gpointer data) {
+    g_source_set_ready_time(src, -1);
+    cb(data);
+    return G_SOURCE_CONTINUE;
+}
 
-    const char *sig = g_getenv("HYPRLAND_INSTANCE_SIGNATURE");
-    if (sig && *sig) {
-        return g_strdup_printf("%s/hypr/%s/.socket2.sock", xdg, sig);
-    }
+static GSourceFuncs refresh_source_funcs = {
+    .dispatch = refresh_source_dispatch,
+};
 
-    // Fallback: scan $XDG_RUNTIME_DIR/hypr/*/.socket2.sock
-    gchar *hypr_dir = g_strdup_printf("%s/hypr", xdg);
-    DIR *d = opendir(hypr_dir);
-    if (!d) { g_free(hypr_dir); return NULL; }
+// Called from the event thread. refresh_pending coalesces a burst into one
+// wakeup; g_source_set_ready_time() is safe from any thread and wakes the
+// main context. No source ids cross threads.
+static void schedule_refresh(AppState *st) {
+    if (!st || !st->refresh_source) return;
+    if (g_atomic_int_get(&st->stop_requested)) return;
 
-    struct dirent *ent;
-    while ((ent = readdir(d))) {
-        if (ent->d_name[0] == '.') continue;
+    if (!g_atomic_int_compare_and_exchange(&st->refresh_pending, 0, 1)) return;
 
-        gchar *candidate = g_strdup_printf("%s/%s/.socket2.sock", hypr_dir, ent->d_name);
-        if (g_file_test(candidate, G_FILE_TEST_EXISTS)) {
-            closedir(d);
-            g_free(hypr_dir);
-            return candidate;
-        }
-        g_free(candidate);
-    }
+    g_source_set_ready_time(st->refresh_source, 0);
+}
 
-    closedir(d);
-    g_free(hypr_dir);
-    return NULL;
+// Sleeps up to ms; returns TRUE early once stop has been requested.
+static gboolean wait_for_stop(AppState *st, int ms) {
+    struct pollfd p = { .fd = st->wake_fd, .events = POLLIN };
+    while (poll(&p, 1, ms) < 0 && errno == EINTR) {}
+    return g_atomic_int_get(&st->stop_requested);
 }
 
-static gpointer hypr_event_thread(gpointer data) {
-    AppState *st = data;
-    if (!st) return NULL;
+static void set_polling(AppState *st, gboolean on) {
+    g_atomic_int_set(&st->want_polling, on ? 1 : 0);
+    schedule_refresh(st);   // the main loop adds/removes the poll source
+}
 
-    char *path = find_hypr_socket2_path();
-    if (!path) {
-        g_warning("Hyprland event socket path not found; using polling fallback");
-        ensure_polling_fallback(st);
-        return NULL;
-    }
+static int connect_event_socket(void) {
+    char *path = hypr_socket_path(".socket2.sock");
+    if (!path) return -1;
 
-    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
     if (fd < 0) {
-        g_warning("socket() failed: %s; using polling fallback", g_strerror(errno));
         g_free(path);
-        ensure_polling_fallback(st);
-        return NULL;
+        return -1;
     }
 
     struct sockaddr_un addr;
@@ -106,52 +203,137 @@ static gpointer hypr_event_thread(gpointer data) {
     addr.sun_family = AF_UNIX;
     g_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
 
+    // Local sockets connect (or fail) immediately even when non-blocking.
     if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        g_warning("connect(%s) failed: %s; using polling fallback", path, g_strerror(errno));
+        g_debug("connect(%s) failed: %s", path, g_strerror(errno));
         close(fd);
         g_free(path);
-        ensure_polling_fallback(st);
-        return NULL;
+        return -1;
     }
 
-    // publish fd so stop() can interrupt the blocking read()
-    st->event_fd = fd;
-
     g_message("Connected to Hyprland event socket: %s", path);
     g_free(path);
+    return fd;
+}
 
-    char buf[4096];
-    GString *acc = g_string_new(NULL);
+// Reads and queues everything currently available on fd; sets *got_data
+// once anything arrived. Returns FALSE once the connection is gone.
+static gboolean read_events(AppState *st, int fd, LineFramer *fr, gboolean *got_data) {
+    gboolean alive = TRUE;
+    gboolean queued = FALSE;
+
+    for (;;) {
+        gsize avail = 0;
+        char *dst = line_framer_reserve(fr, &avail);
+
+        ssize_t n = read(fd, dst, avail);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) alive = FALSE;
+            break;
+        }
+        if (n == 0) {
+            alive = FALSE;
+            break;
+        }
+        line_framer_commit(fr, (gsize)n);
+        *got_data = TRUE;
+        gint64 now = g_get_monotonic_time();   // one stamp per read() is plenty
+
+        const char *line;
+        gsize linelen;
+        while (line_framer_next(fr, &line, &linelen)) {
+            gsize off = 0;
+            const HyprEventClass *ec = classify_event(line, linelen, &off);
+
+            if (!ec || !(ec->bits & HYPR_DIRTY_HANDLED)) {
+                g_atomic_int_inc(&st->events_dropped);
+                continue;
+            }
+
+            g_atomic_int_inc(&st->events_acted);
+            // A full queue flags overflow; the main loop then resyncs.
+            event_queue_push(st->events, ec->bits, ec->kind, now, line + off, linelen - off);
+            queued = TRUE;
+        }
+    }
 
-    while (!g_atomic_int_get(&st->stop_requested)) {
-        ssize_t n = read(fd, buf, sizeof(buf));
-        if (n <= 0) break;
+    // One wakeup per batch rather than per line.
+    if (queued) schedule_refresh(st);
+    return alive;
+}
 
-        g_string_append_len(acc, buf, (gssize)n);
+#define RECONNECT_MIN_MS 250
+#define RECONNECT_MAX_MS 30000
+#define RECONNECT_STABLE_MS 5000    // a connection this old (or that saw data) resets the backoff
 
-        for (;;) {
-            char *nl = strchr(acc->str, '\n');
-            if (!nl) break;
+static gpointer hypr_event_thread(gpointer data) {
+    AppState *st = data;
+    if (!st) return NULL;
 
-            // Any event -> refresh (coalesced)
-            schedule_refresh(st);
+    LineFramer *fr = line_framer_new();
+    int backoff = RECONNECT_MIN_MS;
+    gboolean warned = FALSE;
 
-            gsize linelen = (gsize)(nl - acc->str);
-            g_string_erase(acc, 0, linelen + 1);
+    while (!g_atomic_int_get(&st->stop_requested)) {
+        int fd = connect_event_socket();
+        if (fd < 0) {
+            if (!warned) {
+                g_warning("Hyprland event socket unavailable; polling until it is back");
+                warned = TRUE;
+            }
+            set_polling(st, TRUE);
+
+            // Exponential backoff with jitter, so a compositor restart is
+            // picked up quickly without hammering a missing socket.
+            int delay = backoff / 2 + g_random_int_range(0, backoff / 2 + 1);
+            if (wait_for_stop(st, delay)) break;
+            backoff = MIN(backoff * 2, RECONNECT_MAX_MS);
+            continue;
+        }
+
+        warned = FALSE;
+        line_framer_reset(fr);
+        gint64 connected_at = g_get_monotonic_time();
+        gboolean got_data = FALSE;
+
+        // Events before this point were missed: start from a full client list.
+        g_atomic_int_set(&st->resync_requested, 1);
+        set_polling(st, FALSE);
+
+        struct pollfd fds[2] = {
+            { .fd = fd,          .events = POLLIN },
+            { .fd = st->wake_fd, .events = POLLIN },
+        };
+
+        while (!g_atomic_int_get(&st->stop_requested)) {
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (fds[1].revents) break;   // woken by hypr_events_stop()
+            if (fds[0].revents && !read_events(st, fd, fr, &got_data)) break;
         }
-    }
 
-    g_string_free(acc, TRUE);
+        close(fd);
+        if (g_atomic_int_get(&st->stop_requested)) break;
 
-    // Close fd here (thread owns it)
-    close(fd);
-    st->event_fd = -1;
+        gboolean stable = got_data || g_get_monotonic_time() - connected_at >= RECONNECT_STABLE_MS * 1000;
+        if (stable) {
+            g_warning("Hyprland event socket disconnected; reconnecting");
+            backoff = RECONNECT_MIN_MS;
+            continue;
+        }
 
-    if (!g_atomic_int_get(&st->stop_requested)) {
-        g_warning("Hyprland event socket disconnected; using polling fallback");
-        ensure_polling_fallback(st);
+        // Accepted and dropped straight away: back off as if connect()
+        // had failed, instead of spinning through resyncs.
+        g_debug("Hyprland event socket closed right after connecting; retrying later");
+        int delay = backoff / 2 + g_random_int_range(0, backoff / 2 + 1);
+        if (wait_for_stop(st, delay)) break;
+        backoff = MIN(backoff * 2, RECONNECT_MAX_MS);
     }
 
+    line_framer_free(fr);
     return NULL;
 }
 
@@ -161,7 +343,23 @@ void hypr_events_start(AppState *st) {
     if (st->event_thread) return; // already started
 
     g_atomic_int_set(&st->stop_requested, 0);
-    st->event_fd = -1;
+
+    st->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (st->wake_fd < 0) {
+        // Without a way to wake the thread we couldn't join it: poll instead.
+        g_warning("eventfd() failed: %s; using polling fallback", g_strerror(errno));
+        g_atomic_int_set(&st->want_polling, 1);
+        poller_start(st);
+        return;
+    }
+
+    GSource *src = g_source_new(&refresh_source_funcs, sizeof(GSource));
+    g_source_set_priority(src, G_PRIORITY_DEFAULT_IDLE);
+    g_source_set_ready_time(src, -1);
+    g_source_set_callback(src, refresh_idle_cb, st, NULL);
+    g_source_set_name(src, "hypr-events refresh");
+    g_source_attach(src, NULL);
+    st->refresh_source = src;
 
     st->event_thread = g_thread_new("hypr-events", hypr_event_thread, st);
 }
@@ -171,28 +369,46 @@ void hypr_events_stop(AppState *st) {
 
     g_atomic_int_set(&st->stop_requested, 1);
 
-    // Cancel polling fallback timer if present
-    if (st->poll_id) {
-        g_source_remove(st->poll_id);
-        st->poll_id = 0;
+    // Wake the thread out of poll() and join it.
+    if (st->wake_fd >= 0) {
+        guint64 one = 1;
+        ssize_t r = write(st->wake_fd, &one, sizeof(one));
+        (void)r;
     }
 
-    // Cancel a queued idle refresh if present
-    if (st->refresh_idle_id) {
-        g_source_remove(st->refresh_idle_id);
-        st->refresh_idle_id = 0;
-        g_atomic_int_set(&st->refresh_pending, 0);
+    if (st->event_thread) {
+        g_thread_join(st->event_thread);
+        st->event_thread = NULL;
+        hypr_events_log_stats(st);
     }
 
-    // Interrupt blocking read()
-    if (st->event_fd >= 0) {
-        shutdown(st->event_fd, SHUT_RDWR);
-        // do not close() here; thread closes it
+    if (st->wake_fd >= 0) {
+        close(st->wake_fd);
+        st->wake_fd = -1;
     }
 
-    // Join thread
-    if (st->event_thread) {
-        g_thread_join(st->event_thread);
-        st->event_thread = NULL;
+    // The thread is gone, so nothing can queue new sources behind our back.
+    poller_stop(st);
+
+    if (st->resync_retry_id) {
+        g_source_remove(st->resync_retry_id);
+        st->resync_retry_id = 0;
+    }
+
+    // Only the joined thread ever woke the source; drop it here, on the
+    // main thread that created it.
+    if (st->refresh_source) {
+        g_source_destroy(st->refresh_source);
+        g_clear_pointer(&st->refresh_source, g_source_unref);
     }
+    g_atomic_int_set(&st->refresh_pending, 0);
+}
+
+void hypr_events_log_stats(AppState *st) {
+    if (!st) return;
+
+    int acted = g_atomic_int_get(&st->events_acted);
+    int dropped = g_atomic_int_get(&st->events_dropped);
+    g_message("Hyprland events: %d acted on, %d dropped (%.0f%% filtered)",
+              acted, dropped, (acted + dropped) ? 100.0 * dropped / (acted + dropped) : 0.0);
 }
@@ -0,0 +1,186 @@
+#include "hypr_ipc.h"
+
+#include <glib.h>
+#include <errno.h>
+#include <dirent.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+// Hyprland joins the replies of a [[BATCH]] request with this delimiter.
+#define HYPR_BATCH_DELIM "\n\n\n"
+
+// Requests run on the main loop: a whole round trip, not each read(), must
+// fit in this. A healthy compositor answers j/clients in well under 1 ms.
+#define HYPR_IPC_TIMEOUT_MS 250
+
+// Resolved request socket path, reused across calls (cleared on connect failure).
+G_LOCK_DEFINE_STATIC(req_path);
+static char *req_path_cached = NULL;
+
+char *hypr_socket_path(const char *name) {
+    const char *xdg = g_getenv("XDG_RUNTIME_DIR");
+    if (!xdg || !name) return NULL;
+
+    const char *sig = g_getenv("HYPRLAND_INSTANCE_SIGNATURE");
+    if (sig && *sig) {
+        return g_strdup_printf("%s/hypr/%s/%s", xdg, sig, name);
+    }
+
+    // Fallback: scan $XDG_RUNTIME_DIR/hypr/*/<name>
+    gchar *hypr_dir = g_strdup_printf("%s/hypr", xdg);
+    DIR *d = opendir(hypr_dir);
+    if (!d) { g_free(hypr_dir); return NULL; }
+
+    struct dirent *ent;
+    while ((ent = readdir(d))) {
+        if (ent->d_name[0] == '.') continue;
+
+        gchar *candidate = g_strdup_printf("%s/%s/%s", hypr_dir, ent->d_name, name);
+        if (g_file_test(candidate, G_FILE_TEST_EXISTS)) {
+            closedir(d);
+            g_free(hypr_dir);
+            return candidate;
+        }
+        g_free(candidate);
+    }
+
+    closedir(d);
+    g_free(hypr_dir);
+    return NULL;
+}
+
+static int connect_request_socket(void) {
+    G_LOCK(req_path);
+    if (!req_path_cached) req_path_cached = hypr_socket_path(".socket.sock");
+    char *path = g_strdup(req_path_cached);
+    G_UNLOCK(req_path);
+
+    if (!path) return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        g_free(path);
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    g_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        g_debug("hypr ipc: connect(%s) failed: %s", path, g_strerror(errno));
+        close(fd);
+        g_free(path);
+
+        // Instance may have restarted under a new signature: rediscover next time.
+        G_LOCK(req_path);
+        g_clear_pointer(&req_path_cached, g_free);
+        G_UNLOCK(req_path);
+        return -1;
+    }
+    g_free(path);
+
+    // Requests are a few bytes, but a wedged compositor must not block the write.
+    struct timeval tv = { .tv_sec = 0, .tv_usec = HYPR_IPC_TIMEOUT_MS * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    return fd;
+}
+
+static gboolean write_all(int fd, const char *buf, gsize len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return FALSE;
+        }
+        buf += n;
+        len -= (gsize)n;
+    }
+    return TRUE;
+}
+
+char *hypr_ipc_request(const char *req) {
+    if (!req || !*req) return NULL;
+
+    gint64 t0 = g_get_monotonic_time();
+
+    int fd = connect_request_socket();
+    if (fd < 0) return NULL;
+
+    if (!write_all(fd, req, strlen(req))) {
+        g_warning("hypr ipc: write failed: %s", g_strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    // Hyprland closes the connection after the reply, so read to EOF, all
+    // within one deadline. A reply cut short is no reply: callers keep what
+    // they had and try again later.
+    gint64 deadline = t0 + HYPR_IPC_TIMEOUT_MS * 1000;
+    GString *buf = g_string_sized_new(16384);
+    char tmp[16384];
+    gboolean ok = TRUE;
+    for (;;) {
+        gint64 left_ms = (deadline - g_get_monotonic_time() + 999) / 1000;
+        struct pollfd p = { .fd = fd, .events = POLLIN };
+        int r = left_ms > 0 ? poll(&p, 1, (int)left_ms) : 0;
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+            g_warning("hypr ipc: no reply to '%s' within %d ms", req, HYPR_IPC_TIMEOUT_MS);
+            ok = FALSE;
+            break;
+        }
+
+        ssize_t n = read(fd, tmp, sizeof(tmp));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            g_warning("hypr ipc: read failed: %s", g_strerror(errno));
+            ok = FALSE;
+        }
+        if (n <= 0) break;
+        g_string_append_len(buf, tmp, (gssize)n);
+    }
+    close(fd);
+
+    if (!ok) {
+        g_string_free(buf, TRUE);
+        return NULL;
+    }
+
+    g_debug("hypr ipc: '%s' -> %" G_GSIZE_FORMAT " bytes in %" G_GINT64_FORMAT " us",
+            req, buf->len, g_get_monotonic_time() - t0);
+
+    return g_string_free(buf, FALSE);
+}
+
+char **hypr_ipc_batch(const char *const *reqs, guint n) {
+    if (!reqs || n == 0) return NULL;
+
+    GString *req = g_string_new("[[BATCH]]");
+    for (guint i = 0; i < n; i++) {
+        if (i > 0) g_string_append_c(req, ';');
+        g_string_append(req, reqs[i]);
+    }
+
+    char *reply = hypr_ipc_request(req->str);
+    g_string_free(req, TRUE);
+    if (!reply) return NULL;
+
+    char **parts = g_strsplit(reply, HYPR_BATCH_DELIM, (gint)n);
+    g_free(reply);
+
+    // Always hand back exactly n replies, even if the compositor dropped some.
+    guint got = g_strv_length(parts);
+    if (got < n) {
+        parts = g_renew(char*, parts, n + 1);
+        for (guint i = got; i < n; i++) parts[i] = g_strdup("");
+        parts[n] = NULL;
+    }
+    return parts;
+}
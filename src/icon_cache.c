@@ -0,0 +1,164 @@
+#include "icon_cache.h"
+#include "icon_pack.h"
+
+struct _IconCacheEntry {
+    GIcon *gicon;
+    int size;
+    int scale;
+    GdkPaintable *paintable;
+    gsize bytes;
+    GList *link;            // in lru, newest first; NULL once dropped from the cache
+    guint users;            // icon_cache_acquire() calls not yet released
+};
+
+static GHashTable *entries;     // IconCacheEntry* -> itself, hashed on the key fields
+static GQueue lru = G_QUEUE_INIT;
+static gsize budget = ICON_CACHE_DEFAULT_BUDGET;
+static gsize bytes;
+static guint64 hits, misses, evictions;
+
+static guint entry_hash(gconstpointer p) {
+    const IconCacheEntry *e = p;
+    return g_icon_hash((gpointer)e->gicon) ^ ((guint)e->size << 8) ^ (guint)e->scale;
+}
+
+static gboolean entry_equal(gconstpointer a, gconstpointer b) {
+    const IconCacheEntry *x = a, *y = b;
+    return x->size == y->size && x->scale == y->scale && g_icon_equal(x->gicon, y->gicon);
+}
+
+static void entry_free(IconCacheEntry *e) {
+    g_object_unref(e->paintable);
+    g_object_unref(e->gicon);
+    g_free(e);
+}
+
+// Takes e out of the cache; its users keep it until they release it.
+static void entry_drop(IconCacheEntry *e) {
+    g_hash_table_remove(entries, e);
+    g_queue_delete_link(&lru, e->link);
+    e->link = NULL;
+    bytes -= e->bytes;
+    if (e->users == 0) entry_free(e);
+}
+
+// Oldest first, skipping entries something still shows.
+static void evict(void) {
+    GList *l = lru.tail;
+    while (l && bytes > budget) {
+        GList *prev = l->prev;
+        IconCacheEntry *e = l->data;
+        if (e->users == 0) {
+            entry_drop(e);
+            evictions++;
+        }
+        l = prev;
+    }
+}
+
+// A new theme resolves names differently; what is on screen keeps the
+// old images until it is rebuilt, but nothing new is served from them.
+static void on_theme_changed(GtkIconTheme *theme, gpointer data) {
+    (void)theme; (void)data;
+    while (lru.head) entry_drop(lru.head->data);
+}
+
+IconCacheEntry *icon_cache_acquire(GIcon *gicon, int size, int scale) {
+    GdkDisplay *dpy = gdk_display_get_default();
+    GtkIconTheme *theme = gtk_icon_theme_get_for_display(dpy);
+
+    if (!entries) {
+        entries = g_hash_table_new(entry_hash, entry_equal);
+        g_signal_connect(theme, "changed", G_CALLBACK(on_theme_changed), NULL);
+    }
+
+    IconCacheEntry probe = { .gicon = gicon, .size = size, .scale = scale };
+    IconCacheEntry *e = g_hash_table_lookup(entries, &probe);
+    if (e) {
+        hits++;
+        g_queue_unlink(&lru, e->link);
+        g_queue_push_head_link(&lru, e->link);
+        e->users++;
+        return e;
+    }
+    misses++;
+
+    e = g_new0(IconCacheEntry, 1);
+    e->gicon = g_object_ref(gicon);
+    e->size = size;
+    e->scale = scale;
+    // Named icons rasterized on an earlier run skip the theme entirely.
+    if (G_IS_THEMED_ICON(gicon)) {
+        const char *const *names = g_themed_icon_get_names(G_THEMED_ICON(gicon));
+        GdkTexture *t = names ? icon_pack_lookup(names[0], size, scale) : NULL;
+        if (t) e->paintable = GDK_PAINTABLE(t);
+    }
+    if (!e->paintable) {
+        e->paintable = GDK_PAINTABLE(gtk_icon_theme_lookup_by_gicon(theme, gicon, size, scale,
+                                                                    gtk_widget_get_default_direction(), 0));
+    }
+    e->bytes = (gsize)size * scale * size * scale * 4;
+
+    g_queue_push_head(&lru, e);
+    e->link = lru.head;
+    g_hash_table_add(entries, e);
+    bytes += e->bytes;
+    e->users = 1;
+
+    evict();
+    return e;
+}
+
+GdkPaintable *icon_cache_entry_paintable(IconCacheEntry *e) {
+    return e->paintable;
+}
+
+void icon_cache_release(IconCacheEntry *e) {
+    if (!e) return;
+    g_return_if_fail(e->users > 0);
+
+    if (--e->users > 0) return;
+    if (!e->link) entry_free(e);    // dropped by a theme change while shown
+    else if (bytes > budget) evict();
+}
+
+static GQuark image_quark(void) {
+    static GQuark q;
+    if (!q) q = g_quark_from_static_string("icon-cache-entry");
+    return q;
+}
+
+void icon_cache_set_image(GtkImage *img, GIcon *gicon, int size, int scale) {
+    IconCacheEntry *e = icon_cache_acquire(gicon, size, scale);
+    gtk_image_set_from_paintable(img, e->paintable);
+    // Replacing the data releases the previous entry; so does finalizing img.
+    g_object_set_qdata_full(G_OBJECT(img), image_quark(), e, (GDestroyNotify)icon_cache_release);
+}
+
+int icon_cache_display_scale(void) {
+    GdkDisplay *dpy = gdk_display_get_default();
+    if (!dpy) return 1;
+
+    GListModel *mons = gdk_display_get_monitors(dpy);
+    int scale = 1;
+    for (guint i = 0; i < g_list_model_get_n_items(mons); i++) {
+        GdkMonitor *m = g_list_model_get_item(mons, i);
+        scale = MAX(scale, gdk_monitor_get_scale_factor(m));
+        g_object_unref(m);
+    }
+    return scale;
+}
+
+void icon_cache_set_budget(gsize b) {
+    budget = b;
+    if (entries) evict();
+}
+
+void icon_cache_log_stats(void) {
+    guint64 lookups = hits + misses;
+    g_message("Icon cache: %u entries, %" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT " KiB, %"
+              G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT " misses (%.1f%%), %"
+              G_GUINT64_FORMAT " evicted",
+              lru.length, bytes >> 10, budget >> 10, hits, misses,
+              lookups ? 100.0 * (double)hits / (double)lookups : 0.0, evictions);
+}
@@ -0,0 +1,552 @@
+#include "icon_pack.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// Same conventions as the desktop index cache: native byte order, only
+// ever read back on the machine that wrote it.
+#define PACK_MAGIC      "SGICON\n"      // 8 bytes with the NUL
+#define PACK_VERSION    1
+#define PACK_BYTE_ORDER 0x01020304u
+#define PACK_ALIGN      16              // pixel rows start on this boundary
+#define PACK_MAX_DEPTH  4               // Inherits= chains followed this far
+
+typedef struct {
+    char magic[8];
+    guint32 version;
+    guint32 byte_order;
+    guint32 n_entries;
+    guint32 n_dirs;
+    guint32 theme;          // string: the icon theme it was built for
+    guint32 strings_len;
+    guint32 entries_off;    // file offsets of the sections below
+    guint32 dirs_off;
+    guint32 strings_off;
+    guint32 reserved;
+} PackHeader;
+
+// Sorted by (name, size, scale) for bsearch. Pixels are GDK_MEMORY_R8G8B8A8
+// (straight alpha, as gdk-pixbuf renders them), width * 4 bytes per row.
+typedef struct {
+    guint32 name;           // string
+    guint16 size;
+    guint16 scale;
+    guint32 width;          // 0 x 0: the theme has no such icon
+    guint32 height;
+    guint32 pixels;         // file offset
+    guint32 reserved;
+} PackEntry;
+
+typedef struct {
+    guint32 path;           // string: theme dir or its icon-theme.cache
+    guint32 reserved;
+    gint64 mtime_ns;        // -1 if it did not exist
+} PackDir;
+
+static GMappedFile *map;
+static GBytes *map_bytes;       // the whole mapping; textures hold slices of it
+static const PackHeader *hdr;
+static const PackEntry *entries;
+static const char *strings;
+
+// Last icon_pack_ensure() request, replayed after a build or theme change.
+static GPtrArray *want_names;   // char* theme icon names, owned
+static GArray *want_sizes;      // int
+static gboolean building, rebuild_pending;
+
+static char *pack_path(void) {
+    return g_build_filename(g_get_user_cache_dir(), "simple-gui", "icons.pack", NULL);
+}
+
+static GtkIconTheme *current_theme(void) {
+    return gtk_icon_theme_get_for_display(gdk_display_get_default());
+}
+
+static gint64 path_mtime(const char *path) {
+    struct stat sb;
+    if (stat(path, &sb) != 0) return -1;
+    return (gint64)sb.st_mtim.tv_sec * G_GINT64_CONSTANT(1000000000) + sb.st_mtim.tv_nsec;
+}
+
+/* Theme dirs */
+
+// The first index.theme for name on the search path, or NULL.
+static GKeyFile *theme_index(char **search, const char *name) {
+    for (char **sp = search; sp && *sp; sp++) {
+        char *file = g_build_filename(*sp, name, "index.theme", NULL);
+        GKeyFile *kf = g_key_file_new();
+        gboolean ok = g_key_file_load_from_file(kf, file, G_KEY_FILE_NONE, NULL);
+        g_free(file);
+        if (ok) return kf;
+        g_key_file_free(kf);
+    }
+    return NULL;
+}
+
+static void add_theme(char **search, const char *name, GPtrArray *themes, int depth) {
+    for (guint i = 0; i < themes->len; i++) {
+        if (strcmp(g_ptr_array_index(themes, i), name) == 0) return;
+    }
+    g_ptr_array_add(themes, g_strdup(name));
+    if (depth >= PACK_MAX_DEPTH) return;
+
+    GKeyFile *kf = theme_index(search, name);
+    if (!kf) return;
+    char **inherits = g_key_file_get_string_list(kf, "Icon Theme", "Inherits", NULL, NULL);
+    for (char **p = inherits; p && *p; p++) add_theme(search, g_strstrip(*p), themes, depth + 1);
+    g_strfreev(inherits);
+    g_key_file_free(kf);
+}
+
+// Every path whose mtime the pack depends on: the search path dirs (a
+// theme dir appearing), each theme dir, and its icon-theme.cache (which
+// package installs regenerate).
+static GPtrArray *theme_paths(GtkIconTheme *theme) {
+    char **search = gtk_icon_theme_get_search_path(theme);
+    char *name = gtk_icon_theme_get_theme_name(theme);
+
+    GPtrArray *themes = g_ptr_array_new_with_free_func(g_free);
+    add_theme(search, name, themes, 0);
+    add_theme(search, "hicolor", themes, 0);
+
+    GPtrArray *paths = g_ptr_array_new_with_free_func(g_free);
+    for (char **sp = search; sp && *sp; sp++) {
+        g_ptr_array_add(paths, g_strdup(*sp));
+        for (guint i = 0; i < themes->len; i++) {
+            const char *t = g_ptr_array_index(themes, i);
+            g_ptr_array_add(paths, g_build_filename(*sp, t, NULL));
+            g_ptr_array_add(paths, g_build_filename(*sp, t, "icon-theme.cache", NULL));
+        }
+    }
+
+    g_ptr_array_free(themes, TRUE);
+    g_free(name);
+    g_strfreev(search);
+    return paths;
+}
+
+/* Reading */
+
+static void pack_close(void) {
+    g_clear_pointer(&map_bytes, g_bytes_unref);
+    g_clear_pointer(&map, g_mapped_file_unref);
+    hdr = NULL;
+    entries = NULL;
+    strings = NULL;
+}
+
+void icon_pack_load(void) {
+    pack_close();
+
+    char *path = pack_path();
+    GMappedFile *m = g_mapped_file_new(path, FALSE, NULL);
+    if (!m) {
+        g_free(path);
+        return;
+    }
+
+    gsize size = g_mapped_file_get_length(m);
+    const char *base = g_mapped_file_get_contents(m);
+    const PackHeader *h = (const PackHeader *)base;
+    const char *why = NULL;
+
+    if (size < sizeof *h || memcmp(h->magic, PACK_MAGIC, sizeof h->magic) != 0
+        || h->version != PACK_VERSION || h->byte_order != PACK_BYTE_ORDER) {
+        why = "invalid";
+    } else if (h->entries_off % 8 || h->dirs_off % 8
+               || h->entries_off + (guint64)h->n_entries * sizeof(PackEntry) > size
+               || h->dirs_off + (guint64)h->n_dirs * sizeof(PackDir) > size
+               || h->strings_len == 0 || h->strings_off + (guint64)h->strings_len > size
+               || base[h->strings_off + h->strings_len - 1] != '\0'
+               || h->theme >= h->strings_len) {
+        why = "invalid";
+    }
+
+    const PackEntry *es = why ? NULL : (const PackEntry *)(base + h->entries_off);
+    for (guint i = 0; es && i < h->n_entries; i++) {
+        const PackEntry *e = &es[i];
+        if (e->name >= h->strings_len
+            || e->pixels + (guint64)e->width * 4 * e->height > size) {
+            why = "invalid";
+            break;
+        }
+    }
+
+    const char *strs = base + (why ? 0 : h->strings_off);
+    if (!why) {
+        char *theme = gtk_icon_theme_get_theme_name(current_theme());
+        if (strcmp(strs + h->theme, theme) != 0) why = "for another theme";
+        g_free(theme);
+    }
+
+    const PackDir *dirs = why ? NULL : (const PackDir *)(base + h->dirs_off);
+    for (guint d = 0; dirs && d < h->n_dirs; d++) {
+        if (dirs[d].path >= h->strings_len) {
+            why = "invalid";
+            break;
+        }
+        if (path_mtime(strs + dirs[d].path) != dirs[d].mtime_ns) {
+            why = "stale";
+            break;
+        }
+    }
+
+    if (why) {
+        g_debug("icon pack: ignoring %s pack %s", why, path);
+        g_mapped_file_unref(m);
+        g_free(path);
+        return;
+    }
+
+    map = m;
+    map_bytes = g_mapped_file_get_bytes(m);
+    hdr = h;
+    entries = es;
+    strings = strs;
+    g_debug("icon pack: mapped %u icons from %s", h->n_entries, path);
+    g_free(path);
+}
+
+typedef struct {
+    const char *name;
+    int size;
+    int scale;
+} PackKey;
+
+static int cmp_key(const char *name_a, int size_a, int scale_a, const char *name_b, int size_b, int scale_b) {
+    int c = strcmp(name_a, name_b);
+    if (c) return c;
+    if (size_a != size_b) return size_a < size_b ? -1 : 1;
+    if (scale_a != scale_b) return scale_a < scale_b ? -1 : 1;
+    return 0;
+}
+
+static int cmp_entry(const void *k, const void *p) {
+    const PackKey *key = k;
+    const PackEntry *e = p;
+    return cmp_key(key->name, key->size, key->scale, strings + e->name, e->size, e->scale);
+}
+
+static const PackEntry *find(const char *name, int size, int scale) {
+    if (!hdr || !name) return NULL;
+    PackKey key = { name, size, scale };
+    return bsearch(&key, entries, hdr->n_entries, sizeof(PackEntry), cmp_entry);
+}
+
+GdkTexture *icon_pack_lookup(const char *name, int size, int scale) {
+    const PackEntry *e = find(name, size, scale);
+    if (!e || e->width == 0) return NULL;
+
+    gsize stride = (gsize)e->width * 4;
+    GBytes *pixels = g_bytes_new_from_bytes(map_bytes, e->pixels, stride * e->height);
+    GdkTexture *t = gdk_memory_texture_new((int)e->width, (int)e->height, GDK_MEMORY_R8G8B8A8, pixels, stride);
+    g_bytes_unref(pixels);
+    return t;
+}
+
+/* Building */
+
+typedef struct {
+    char *name;
+    int size;
+    int scale;
+    char *file;             // what the theme resolved it to; NULL if nothing usable
+} PackJob;
+
+typedef struct {
+    GArray *jobs;           // PackJob, sorted like the entries
+    GPtrArray *paths;       // char* theme paths
+    GArray *mtimes;         // gint64, per path, taken before rasterizing
+    char *theme;
+    char *out;
+} PackBuild;
+
+static void pack_job_clear(gpointer p) {
+    PackJob *j = p;
+    g_free(j->name);
+    g_free(j->file);
+}
+
+static void pack_build_free(gpointer p) {
+    PackBuild *b = p;
+    g_array_free(b->jobs, TRUE);
+    g_ptr_array_free(b->paths, TRUE);
+    g_array_free(b->mtimes, TRUE);
+    g_free(b->theme);
+    g_free(b->out);
+    g_free(b);
+}
+
+static gint cmp_jobs(gconstpointer a, gconstpointer b) {
+    const PackJob *x = a, *y = b;
+    return cmp_key(x->name, x->size, x->scale, y->name, y->size, y->scale);
+}
+
+static guint32 pack_intern(GString *strs, GHashTable *seen, const char *s) {
+    if (!s || !*s) return 0;
+    gpointer off;
+    if (g_hash_table_lookup_extended(seen, s, NULL, &off)) return GPOINTER_TO_UINT(off);
+    guint32 o = (guint32)strs->len;
+    g_string_append_len(strs, s, (gssize)strlen(s) + 1);
+    g_hash_table_insert(seen, g_strdup(s), GUINT_TO_POINTER(o));
+    return o;
+}
+
+static void pad_to(GByteArray *a, gsize align) {
+    static const guint8 zero[PACK_ALIGN];
+    if (a->len % align) g_byte_array_append(a, zero, (guint)(align - a->len % align));
+}
+
+// Worker thread: gdk-pixbuf and plain file I/O only, nothing from GTK.
+static void build_thread(GTask *task, gpointer source, gpointer data, GCancellable *cancel) {
+    (void)source; (void)cancel;
+    PackBuild *b = data;
+    gint64 t0 = g_get_monotonic_time();
+
+    GString *strs = g_string_new_len("", 1);    // offset 0: ""
+    GHashTable *seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    GArray *es = g_array_sized_new(FALSE, TRUE, sizeof(PackEntry), b->jobs->len);
+    GByteArray *pixels = g_byte_array_new();
+    guint rendered = 0;
+
+    for (guint i = 0; i < b->jobs->len; i++) {
+        const PackJob *j = &g_array_index(b->jobs, PackJob, i);
+        PackEntry e = {
+            .name = pack_intern(strs, seen, j->name),
+            .size = (guint16)j->size,
+            .scale = (guint16)j->scale,
+        };
+
+        int px = j->size * j->scale;
+        GdkPixbuf *pb = j->file ? gdk_pixbuf_new_from_file_at_scale(j->file, px, px, TRUE, NULL) : NULL;
+        if (pb && !gdk_pixbuf_get_has_alpha(pb)) {
+            GdkPixbuf *with_alpha = gdk_pixbuf_add_alpha(pb, FALSE, 0, 0, 0);
+            g_object_unref(pb);
+            pb = with_alpha;
+        }
+        if (pb && gdk_pixbuf_get_bits_per_sample(pb) == 8 && gdk_pixbuf_get_n_channels(pb) == 4) {
+            int w = gdk_pixbuf_get_width(pb), h = gdk_pixbuf_get_height(pb);
+            int rowstride = gdk_pixbuf_get_rowstride(pb);
+            const guint8 *src = gdk_pixbuf_read_pixels(pb);
+
+            pad_to(pixels, PACK_ALIGN);
+            e.width = (guint32)w;
+            e.height = (guint32)h;
+            e.pixels = pixels->len;     // relative until the layout is known
+            for (int y = 0; y < h; y++) g_byte_array_append(pixels, src + (gsize)y * rowstride, (guint)w * 4);
+            rendered++;
+        }
+        g_clear_object(&pb);
+        g_array_append_val(es, e);
+    }
+
+    GArray *dirs = g_array_sized_new(FALSE, TRUE, sizeof(PackDir), b->paths->len);
+    for (guint d = 0; d < b->paths->len; d++) {
+        PackDir pd = {
+            .path = pack_intern(strs, seen, g_ptr_array_index(b->paths, d)),
+            .mtime_ns = g_array_index(b->mtimes, gint64, d),
+        };
+        g_array_append_val(dirs, pd);
+    }
+
+    PackHeader h = {
+        .version = PACK_VERSION,
+        .byte_order = PACK_BYTE_ORDER,
+        .n_entries = es->len,
+        .n_dirs = dirs->len,
+        .theme = pack_intern(strs, seen, b->theme),
+    };
+    memcpy(h.magic, PACK_MAGIC, sizeof h.magic);
+    h.strings_len = (guint32)strs->len;
+    h.entries_off = sizeof h;
+    h.dirs_off = h.entries_off + es->len * (guint32)sizeof(PackEntry);
+    h.strings_off = h.dirs_off + dirs->len * (guint32)sizeof(PackDir);
+    guint32 pixels_off = (h.strings_off + h.strings_len + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+
+    for (guint i = 0; i < es->len; i++) {
+        PackEntry *e = &g_array_index(es, PackEntry, i);
+        if (e->width) e->pixels += pixels_off;
+    }
+
+    GByteArray *out = g_byte_array_sized_new(pixels_off + pixels->len);
+    g_byte_array_append(out, (const guint8 *)&h, sizeof h);
+    g_byte_array_append(out, (const guint8 *)es->data, es->len * (guint)sizeof(PackEntry));
+    g_byte_array_append(out, (const guint8 *)dirs->data, dirs->len * (guint)sizeof(PackDir));
+    g_byte_array_append(out, (const guint8 *)strs->str, h.strings_len);
+    pad_to(out, PACK_ALIGN);
+    g_byte_array_append(out, pixels->data, pixels->len);
+
+    // Renamed over the old pack: a mapping of it stays valid.
+    GError *err = NULL;
+    char *dir = g_path_get_dirname(b->out);
+    gboolean ok = FALSE;
+    if (g_mkdir_with_parents(dir, 0700) != 0) {
+        g_warning("icon pack: cannot create %s: %s", dir, g_strerror(errno));
+    } else if (!g_file_set_contents(b->out, (const char *)out->data, (gssize)out->len, &err)) {
+        g_warning("icon pack: cannot write %s: %s", b->out, err->message);
+        g_error_free(err);
+    } else {
+        ok = TRUE;
+        g_debug("icon pack: %u of %u icons rasterized, %u KiB, %.1f ms",
+                rendered, es->len, out->len >> 10, (g_get_monotonic_time() - t0) / 1000.0);
+    }
+
+    g_free(dir);
+    g_byte_array_free(out, TRUE);
+    g_byte_array_free(pixels, TRUE);
+    g_array_free(dirs, TRUE);
+    g_array_free(es, TRUE);
+    g_hash_table_destroy(seen);
+    g_string_free(strs, TRUE);
+    g_task_return_boolean(task, ok);
+}
+
+static void ensure_wanted(void);
+
+static void on_build_done(GObject *source, GAsyncResult *res, gpointer data) {
+    (void)source; (void)data;
+    building = FALSE;
+    if (g_task_propagate_boolean(G_TASK(res), NULL)) icon_pack_load();
+
+    if (rebuild_pending) {
+        rebuild_pending = FALSE;
+        ensure_wanted();
+    }
+}
+
+// Theme lookups stay on the main thread (they are quick with the theme's
+// own cache); only rasterizing and writing go to the worker.
+static void start_build(GArray *keys) {
+    GtkIconTheme *theme = current_theme();
+
+    PackBuild *b = g_new0(PackBuild, 1);
+    b->jobs = g_array_sized_new(FALSE, TRUE, sizeof(PackJob), keys->len);
+    g_array_set_clear_func(b->jobs, pack_job_clear);
+    b->theme = gtk_icon_theme_get_theme_name(theme);
+    b->out = pack_path();
+
+    b->paths = theme_paths(theme);
+    b->mtimes = g_array_sized_new(FALSE, FALSE, sizeof(gint64), b->paths->len);
+    for (guint d = 0; d < b->paths->len; d++) {
+        gint64 mt = path_mtime(g_ptr_array_index(b->paths, d));
+        g_array_append_val(b->mtimes, mt);
+    }
+
+    for (guint i = 0; i < keys->len; i++) {
+        const PackKey *k = &g_array_index(keys, PackKey, i);
+        PackJob j = { .name = g_strdup(k->name), .size = k->size, .scale = k->scale };
+
+        // Only the icon itself: a fallback would be baked in for good.
+        GtkIconPaintable *icon = gtk_icon_theme_lookup_icon(theme, k->name, NULL, k->size, k->scale,
+                                                            GTK_TEXT_DIR_NONE, 0);
+        GFile *file = gtk_icon_paintable_get_file(icon);
+        const char *got = gtk_icon_paintable_get_icon_name(icon);
+        if (file && g_strcmp0(got, k->name) == 0) j.file = g_file_get_path(file);
+        g_clear_object(&file);
+        g_object_unref(icon);
+
+        g_array_append_val(b->jobs, j);
+    }
+    g_array_sort(b->jobs, cmp_jobs);
+
+    building = TRUE;
+    GTask *task = g_task_new(NULL, NULL, on_build_done, NULL);
+    g_task_set_task_data(task, b, pack_build_free);
+    g_task_run_in_thread(task, build_thread);
+    g_object_unref(task);
+}
+
+static GArray *monitor_scales(void) {
+    GArray *scales = g_array_new(FALSE, FALSE, sizeof(int));
+    GListModel *mons = gdk_display_get_monitors(gdk_display_get_default());
+    for (guint i = 0; i < g_list_model_get_n_items(mons); i++) {
+        GdkMonitor *m = g_list_model_get_item(mons, i);
+        int s = gdk_monitor_get_scale_factor(m);
+        g_object_unref(m);
+
+        gboolean have = FALSE;
+        for (guint k = 0; k < scales->len; k++) have |= g_array_index(scales, int, k) == s;
+        if (!have) g_array_append_val(scales, s);
+    }
+    if (scales->len == 0) {
+        int one = 1;
+        g_array_append_val(scales, one);
+    }
+    return scales;
+}
+
+static void ensure_wanted(void) {
+    if (!want_names || !want_sizes) return;
+    if (building) {
+        rebuild_pending = TRUE;
+        return;
+    }
+
+    GArray *scales = monitor_scales();
+    GArray *keys = g_array_new(FALSE, FALSE, sizeof(PackKey));
+    gboolean complete = hdr != NULL;
+    for (guint n = 0; n < want_names->len; n++) {
+        for (guint s = 0; s < want_sizes->len; s++) {
+            for (guint c = 0; c < scales->len; c++) {
+                PackKey k = { g_ptr_array_index(want_names, n), g_array_index(want_sizes, int, s),
+                              g_array_index(scales, int, c) };
+                g_array_append_val(keys, k);
+                if (complete && !find(k.name, k.size, k.scale)) complete = FALSE;
+            }
+        }
+    }
+
+    if (!complete) start_build(keys);
+    g_array_free(keys, TRUE);
+    g_array_free(scales, TRUE);
+}
+
+static void on_theme_changed(GtkIconTheme *theme, gpointer data) {
+    (void)theme; (void)data;
+    icon_pack_load();
+    ensure_wanted();
+}
+
+// Theme names as desktop_index_icon() turns them into GThemedIcons.
+void icon_pack_ensure(const DesktopIndex *apps, const int *sizes, guint n_sizes) {
+    static gboolean watching;
+    if (!watching) {
+        g_signal_connect(current_theme(), "changed", G_CALLBACK(on_theme_changed), NULL);
+        watching = TRUE;
+    }
+
+    GHashTable *names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    for (guint i = 0; apps && i < apps->n; i++) {
+        if (desktop_index_flags(apps, i) & DESKTOP_ENTRY_INACTIVE) continue;
+        const char *icon = desktop_index_get(apps, i, DESKTOP_FIELD_ICON);
+        if (!*icon || g_path_is_absolute(icon)) continue;
+
+        gsize len = strlen(icon);
+        if (g_str_has_suffix(icon, ".png") || g_str_has_suffix(icon, ".svg") || g_str_has_suffix(icon, ".xpm")) len -= 4;
+        g_hash_table_add(names, g_strndup(icon, len));
+    }
+
+    if (want_names) g_ptr_array_free(want_names, TRUE);
+    want_names = g_ptr_array_new_with_free_func(g_free);
+    GHashTableIter iter;
+    gpointer name;
+    g_hash_table_iter_init(&iter, names);
+    while (g_hash_table_iter_next(&iter, &name, NULL)) {
+        g_hash_table_iter_steal(&iter);
+        g_ptr_array_add(want_names, name);
+    }
+    g_hash_table_destroy(names);
+
+    if (!want_sizes) want_sizes = g_array_new(FALSE, FALSE, sizeof(int));
+    g_array_set_size(want_sizes, 0);
+    for (guint s = 0; s < n_sizes; s++) {
+        gboolean have = FALSE;
+        for (guint k = 0; k < want_sizes->len; k++) have |= g_array_index(want_sizes, int, k) == sizes[s];
+        if (!have) g_array_append_val(want_sizes, sizes[s]);
+    }
+
+    ensure_wanted();
+}
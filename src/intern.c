@@ -0,0 +1,74 @@
+#include "intern.h"
+
+#include <string.h>
+
+// Lowercasing goes through a stack buffer this large; longer strings
+// (rare for classes and ids) take one temporary allocation.
+#define INTERN_STACK_LEN 256
+
+static GMutex lock;
+static GHashTable *pool;        // canonical char* -> itself
+static GStringChunk *chunk;     // storage for the canonical copies
+static InternStats stats;
+
+static const char *lookup_or_insert(const char *s, gsize n) {
+    g_mutex_lock(&lock);
+    if (!pool) {
+        pool = g_hash_table_new(g_str_hash, g_str_equal);
+        chunk = g_string_chunk_new(4096);
+    }
+
+    stats.lookups++;
+    const char *canon = g_hash_table_lookup(pool, s);
+    if (canon) {
+        stats.hits++;
+    } else {
+        canon = g_string_chunk_insert_len(chunk, s, (gssize)n);
+        g_hash_table_add(pool, (gpointer)canon);
+        stats.strings++;
+        stats.text_bytes += n + 1;
+    }
+    g_mutex_unlock(&lock);
+    return canon;
+}
+
+const char *intern(const char *s) {
+    if (!s) return NULL;
+    return lookup_or_insert(s, strlen(s));
+}
+
+const char *intern_lower_len(const char *s, gsize n) {
+    if (!s) return NULL;
+
+    char buf[INTERN_STACK_LEN];
+    char *low = n < sizeof buf ? buf : g_malloc(n + 1);
+    for (gsize i = 0; i < n; i++) low[i] = g_ascii_tolower(s[i]);
+    low[n] = '\0';
+
+    const char *canon = lookup_or_insert(low, n);
+    if (low != buf) g_free(low);
+    return canon;
+}
+
+const char *intern_lower(const char *s) {
+    if (!s) return NULL;
+    return intern_lower_len(s, strlen(s));
+}
+
+void intern_get_stats(InternStats *out) {
+    g_mutex_lock(&lock);
+    *out = stats;
+    // GHashTable keeps a hash, a key and (for sets) no separate value per
+    // slot, at up to twice the entries in slots.
+    out->table_bytes = (gsize)stats.strings * 2 * (sizeof(guint) + sizeof(gpointer));
+    g_mutex_unlock(&lock);
+}
+
+void intern_log_stats(void) {
+    InternStats s;
+    intern_get_stats(&s);
+    g_message("Interned strings: %u (%" G_GSIZE_FORMAT " bytes text, ~%" G_GSIZE_FORMAT
+              " bytes table), %" G_GUINT64_FORMAT " lookups, %.1f%% hits",
+              s.strings, s.text_bytes, s.table_bytes, s.lookups,
+              s.lookups ? 100.0 * (double)s.hits / (double)s.lookups : 0.0);
+}
@@ -0,0 +1,409 @@
+#include "json_scan.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JSON_SCAN_X86 1
+#endif
+
+/* Character scanners */
+
+// Structural characters outside strings: " { } [ ] , :
+static const unsigned char is_struct[256] = {
+    ['"'] = 1, ['{'] = 1, ['}'] = 1, ['['] = 1, [']'] = 1, [','] = 1, [':'] = 1,
+};
+
+static const char *find_struct_scalar(const char *p, const char *end) {
+    while (p < end && !is_struct[(unsigned char)*p]) p++;
+    return p;
+}
+
+// Inside a string only the closing quote and escapes matter.
+static const char *find_quote_scalar(const char *p, const char *end) {
+    while (p < end && *p != '"' && *p != '\\') p++;
+    return p;
+}
+
+#ifdef JSON_SCAN_X86
+
+// '[' and ']' differ from '{' and '}' only in bit 0x20, so OR-ing it in
+// covers all four brackets with two compares.
+__attribute__((target("sse2")))
+static const char *find_struct_sse2(const char *p, const char *end) {
+    const __m128i bit = _mm_set1_epi8(0x20);
+    const __m128i ob = _mm_set1_epi8('{'), cb = _mm_set1_epi8('}');
+    const __m128i qu = _mm_set1_epi8('"'), co = _mm_set1_epi8(','), cl = _mm_set1_epi8(':');
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i f = _mm_or_si128(v, bit);
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(f, ob), _mm_cmpeq_epi8(f, cb)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, qu),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, co), _mm_cmpeq_epi8(v, cl))));
+        unsigned mask = (unsigned)_mm_movemask_epi8(m);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return find_struct_scalar(p, end);
+}
+
+__attribute__((target("sse2")))
+static const char *find_quote_sse2(const char *p, const char *end) {
+    const __m128i qu = _mm_set1_epi8('"'), bs = _mm_set1_epi8('\\');
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, qu), _mm_cmpeq_epi8(v, bs));
+        unsigned mask = (unsigned)_mm_movemask_epi8(m);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return find_quote_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char *find_quote_avx2(const char *p, const char *end) {
+    const __m256i qu = _mm256_set1_epi8('"'), bs = _mm256_set1_epi8('\\');
+
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, qu), _mm256_cmpeq_epi8(v, bs));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return find_quote_sse2(p, end);
+}
+
+#endif // JSON_SCAN_X86
+
+typedef const char *(*scan_fn)(const char *, const char *);
+
+static scan_fn find_struct = NULL;
+static scan_fn find_quote = NULL;
+
+// Racing initialisations all store the same pointers, so no lock is needed.
+static void scan_select_impl(void) {
+    scan_fn s = find_struct_scalar, q = find_quote_scalar;
+#ifdef JSON_SCAN_X86
+    __builtin_cpu_init();
+    // Structural characters in pretty-printed replies are only a few bytes
+    // apart, so 32-byte blocks mostly do wasted work there; wide loads pay off
+    // for string bodies (titles) where the next quote is usually far away.
+    if (__builtin_cpu_supports("sse2")) {
+        s = find_struct_sse2;
+        q = find_quote_sse2;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        q = find_quote_avx2;
+    }
+#endif
+    find_quote = q;
+    find_struct = s;
+}
+
+/* Extractor */
+
+typedef struct {
+    const char *seg[2];
+    size_t seglen[2];
+    int nseg;
+} ScanPath;
+
+static int slice_eq(const char *a, size_t alen, const char *b, size_t blen) {
+    return alen == blen && memcmp(a, b, alen) == 0;
+}
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+long json_scan_objects(const char *js, size_t len,
+                       const char *const *paths, int npaths,
+                       JsonScanFunc cb, void *user) {
+    if (!js || npaths < 0 || npaths > JSON_SCAN_MAX_PATHS) return -1;
+    if (!find_struct) scan_select_impl();
+
+    ScanPath pt[JSON_SCAN_MAX_PATHS];
+    for (int i = 0; i < npaths; i++) {
+        const char *dot = strchr(paths[i], '.');
+        pt[i].seg[0] = paths[i];
+        if (dot) {
+            pt[i].seglen[0] = (size_t)(dot - paths[i]);
+            pt[i].seg[1] = dot + 1;
+            pt[i].seglen[1] = strlen(dot + 1);
+            pt[i].nseg = 2;
+        } else {
+            pt[i].seglen[0] = strlen(paths[i]);
+            pt[i].seg[1] = NULL;
+            pt[i].seglen[1] = 0;
+            pt[i].nseg = 1;
+        }
+    }
+
+    JsonScanValue vals[JSON_SCAN_MAX_PATHS];
+    memset(vals, 0, sizeof(vals));
+
+    const char *p = js;
+    const char *end = js + len;
+
+    uint64_t obj_bits = 0;   // bit d-1 set: container at depth d is an object
+    int depth = 0;
+    int elem_depth = 0;      // depth of reported objects: 2 inside '[', 1 for a bare '{'
+    int expect_key = 0;
+
+    int want = -1;           // path whose value comes next
+    const char *prim = NULL; // start of a primitive value being captured
+
+    const char *nest = NULL; // key owning the nested object we match inside
+    size_t nest_len = 0;
+    int nest_pending = 0;    // last key may own a nested object
+    int nest_active = 0;
+
+    long count = 0;
+
+    while (p < end) {
+        p = find_struct(p, end);
+        if (p >= end) break;
+
+        char c = *p;
+        switch (c) {
+        case '"': {
+            const char *s = p + 1;
+            const char *q = s;
+            int esc = 0;
+            for (;;) {
+                q = find_quote(q, end);
+                if (q >= end) return -1; // unterminated string
+                if (*q != '\\') break;
+                esc = 1;
+                q += 2;
+            }
+
+            int in_obj = depth > 0 && ((obj_bits >> (depth - 1)) & 1);
+            if (in_obj && expect_key) {
+                size_t klen = (size_t)(q - s);
+                expect_key = 0;
+                want = -1;
+                nest_pending = 0;
+
+                if (depth == elem_depth) {
+                    for (int i = 0; i < npaths; i++) {
+                        if (!slice_eq(s, klen, pt[i].seg[0], pt[i].seglen[0])) continue;
+                        if (pt[i].nseg == 1) {
+                            if (want < 0) want = i;
+                        } else {
+                            nest_pending = 1;
+                            nest = s;
+                            nest_len = klen;
+                        }
+                    }
+                } else if (depth == elem_depth + 1 && nest_active) {
+                    for (int i = 0; i < npaths; i++) {
+                        if (pt[i].nseg == 2 &&
+                            slice_eq(nest, nest_len, pt[i].seg[0], pt[i].seglen[0]) &&
+                            slice_eq(s, klen, pt[i].seg[1], pt[i].seglen[1])) {
+                            want = i;
+                            break;
+                        }
+                    }
+                }
+            } else {
+                if (want >= 0) {
+                    vals[want].ptr = s;
+                    vals[want].len = (size_t)(q - s);
+                    vals[want].type = JSON_SCAN_STRING;
+                    vals[want].escaped = esc;
+                }
+                want = -1;
+                prim = NULL;
+                nest_pending = 0;
+            }
+            p = q + 1;
+            break;
+        }
+
+        case ':':
+            if (want >= 0) prim = p + 1;
+            p++;
+            break;
+
+        case '{': case '[':
+            if (depth >= JSON_SCAN_MAX_DEPTH) return -1;
+            if (depth == 0) {
+                if (elem_depth) return count; // trailing document: stop
+                elem_depth = (c == '[') ? 2 : 1;
+            }
+            if (c == '{' && nest_pending && depth == elem_depth) nest_active = 1;
+            want = -1;
+            prim = NULL;
+            nest_pending = 0;
+
+            depth++;
+            if (c == '{') obj_bits |= (uint64_t)1 << (depth - 1);
+            else obj_bits &= ~((uint64_t)1 << (depth - 1));
+            expect_key = (c == '{');
+
+            if (c == '{' && depth == elem_depth) memset(vals, 0, sizeof(vals));
+            p++;
+            break;
+
+        case ',': case '}': case ']': {
+            if (want >= 0 && prim) {
+                const char *a = prim, *b = p;
+                while (a < b && is_space(*a)) a++;
+                while (b > a && is_space(b[-1])) b--;
+                if (b > a) {
+                    vals[want].ptr = a;
+                    vals[want].len = (size_t)(b - a);
+                    vals[want].type = JSON_SCAN_PRIMITIVE;
+                    vals[want].escaped = 0;
+                }
+            }
+            want = -1;
+            prim = NULL;
+            nest_pending = 0;
+
+            if (c == ',') {
+                expect_key = depth > 0 && ((obj_bits >> (depth - 1)) & 1);
+                p++;
+                break;
+            }
+
+            if (depth == 0) return -1;
+            int was_obj = (obj_bits >> (depth - 1)) & 1;
+            if (was_obj != (c == '}')) return -1;
+
+            if (c == '}' && depth == elem_depth) {
+                if (cb) cb(vals, user);
+                count++;
+            }
+            if (depth == elem_depth + 1) nest_active = 0;
+
+            depth--;
+            expect_key = 0;
+            p++;
+            if (depth == 0) return count;
+            break;
+        }
+        }
+    }
+
+    return (depth == 0 && elem_depth) ? count : -1;
+}
+
+/* Value helpers */
+
+static int hex_val(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int read_u16(const char *s, size_t left, unsigned *out) {
+    if (left < 4) return 0;
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        int h = hex_val(s[i]);
+        if (h < 0) return 0;
+        v = (v << 4) | (unsigned)h;
+    }
+    *out = v;
+    return 1;
+}
+
+static size_t put_utf8(char *out, unsigned cp) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Every escape is at least as long as its UTF-8 output, so len bytes suffice.
+size_t json_unescape(const char *s, size_t len, char *out) {
+    size_t o = 0;
+    size_t i = 0;
+
+    while (i < len) {
+        char c = s[i];
+        if (c != '\\' || i + 1 >= len) {
+            out[o++] = c;
+            i++;
+            continue;
+        }
+
+        char e = s[i + 1];
+        i += 2;
+        switch (e) {
+        case 'b': out[o++] = '\b'; break;
+        case 'f': out[o++] = '\f'; break;
+        case 'n': out[o++] = '\n'; break;
+        case 'r': out[o++] = '\r'; break;
+        case 't': out[o++] = '\t'; break;
+        case 'u': {
+            unsigned cp;
+            if (!read_u16(s + i, len - i, &cp)) {
+                out[o++] = '?';
+                break;
+            }
+            i += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                unsigned lo;
+                if (i + 1 < len && s[i] == '\\' && s[i + 1] == 'u' &&
+                    read_u16(s + i + 2, len - i - 2, &lo) && lo >= 0xDC00 && lo <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    i += 6;
+                } else {
+                    cp = 0xFFFD;
+                }
+            } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                cp = 0xFFFD;
+            }
+            o += put_utf8(out + o, cp);
+            break;
+        }
+        default: out[o++] = e; break; // \" \\ \/
+        }
+    }
+    return o;
+}
+
+long long json_scan_int(const JsonScanValue *v, long long dflt) {
+    if (!v || v->type != JSON_SCAN_PRIMITIVE || v->len == 0) return dflt;
+
+    size_t i = 0;
+    int neg = 0;
+    if (v->ptr[0] == '-') {
+        neg = 1;
+        i = 1;
+    }
+    if (i >= v->len || v->ptr[i] < '0' || v->ptr[i] > '9') return dflt;
+
+    long long n = 0;
+    for (; i < v->len; i++) {
+        char c = v->ptr[i];
+        if (c < '0' || c > '9') break;
+        n = n * 10 + (c - '0');
+    }
+    return neg ? -n : n;
+}
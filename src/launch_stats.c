@@ -0,0 +1,157 @@
+#include "launch_stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void launch_app_free(gpointer p) {
+    LaunchApp *a = p;
+    if (!a) return;
+    g_array_free(a->pending, TRUE);
+    g_free(a);
+}
+
+LaunchStats *launch_stats_new(void) {
+    LaunchStats *ls = g_new0(LaunchStats, 1);
+    ls->apps = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, launch_app_free);
+    return ls;
+}
+
+void launch_stats_free(LaunchStats *ls) {
+    if (!ls) return;
+    g_hash_table_destroy(ls->apps);
+    g_free(ls);
+}
+
+static LaunchApp *app_get(LaunchStats *ls, const char *key) {
+    LaunchApp *a = g_hash_table_lookup(ls->apps, key);
+    if (a) return a;
+
+    a = g_new0(LaunchApp, 1);
+    a->pending = g_array_new(FALSE, FALSE, sizeof(gint64));
+    g_hash_table_insert(ls->apps, g_strdup(key), a);
+    return a;
+}
+
+// Drops launches that have been waiting longer than LAUNCH_TIMEOUT_US.
+static void expire_pending(LaunchApp *a, gint64 now) {
+    guint stale = 0;
+    while (stale < a->pending->len && now - g_array_index(a->pending, gint64, stale) > LAUNCH_TIMEOUT_US) {
+        stale++;
+    }
+    if (stale) {
+        a->timeouts += stale;
+        g_array_remove_range(a->pending, 0, stale);
+    }
+}
+
+void launch_stats_begin(LaunchStats *ls, const char *match_key) {
+    if (!ls || !match_key || !*match_key) return;
+
+    gint64 now = g_get_monotonic_time();
+    LaunchApp *a = app_get(ls, match_key);
+    expire_pending(a, now);
+    g_array_append_val(a->pending, now);
+}
+
+static guint bucket_for(gint64 us) {
+    gint64 ms = us / 1000;
+    guint b = 0;
+    while (ms > 1 && b < LAUNCH_HIST_BUCKETS - 1) {
+        ms >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void launch_stats_note_open(LaunchStats *ls, const char *data, gint64 time_us) {
+    if (!ls || !data || g_hash_table_size(ls->apps) == 0) return;
+
+    // ADDRESS,WORKSPACENAME,CLASS,TITLE
+    const char *p = strchr(data, ',');
+    if (p) p = strchr(p + 1, ',');
+    if (!p) return;
+    p++;
+
+    const char *end = strchr(p, ',');
+    gsize n = end ? (gsize)(end - p) : strlen(p);
+
+    char cls[256];
+    if (n >= sizeof(cls)) return;
+    for (gsize i = 0; i < n; i++) cls[i] = g_ascii_tolower(p[i]);
+    cls[n] = '\0';
+    g_strstrip(cls);
+
+    LaunchApp *a = g_hash_table_lookup(ls->apps, cls);
+    if (!a) return;
+
+    expire_pending(a, time_us);
+    if (a->pending->len == 0) return;
+
+    // Windows arrive in launch order; the oldest launch gets this one.
+    gint64 lat = time_us - g_array_index(a->pending, gint64, 0);
+    g_array_remove_index(a->pending, 0);
+    if (lat < 0) lat = 0;
+
+    if (a->count == 0 || lat < a->min_us) a->min_us = lat;
+    if (lat > a->max_us) a->max_us = lat;
+    a->sum_us += lat;
+    a->count++;
+    a->hist[bucket_for(lat)]++;
+
+    g_debug("launch latency %s: %" G_GINT64_FORMAT " ms", cls, lat / 1000);
+}
+
+// Upper edge (ms) of the bucket holding the q-th fraction of samples.
+static guint64 hist_quantile(const LaunchApp *a, double q) {
+    guint64 want = (guint64)(q * (double)a->count + 0.5);
+    if (want == 0) want = 1;
+
+    guint64 seen = 0;
+    for (guint b = 0; b < LAUNCH_HIST_BUCKETS; b++) {
+        seen += a->hist[b];
+        if (seen >= want) return (guint64)1 << (b + 1);
+    }
+    return (guint64)1 << LAUNCH_HIST_BUCKETS;
+}
+
+static gint cmp_keys(gconstpointer a, gconstpointer b) {
+    return g_strcmp0(*(const char *const *)a, *(const char *const *)b);
+}
+
+void launch_stats_dump(LaunchStats *ls) {
+    if (!ls) return;
+
+    guint n = 0;
+    gpointer *keys = g_hash_table_get_keys_as_array(ls->apps, &n);
+    qsort(keys, n, sizeof(gpointer), cmp_keys);
+
+    g_message("Launch latency (click to first window), %u app(s):", n);
+    gint64 now = g_get_monotonic_time();
+
+    for (guint i = 0; i < n; i++) {
+        LaunchApp *a = g_hash_table_lookup(ls->apps, keys[i]);
+        expire_pending(a, now);
+
+        if (a->count == 0) {
+            g_message("  %s: no windows seen (%" G_GUINT64_FORMAT " timed out, %u pending)",
+                      (const char *)keys[i], a->timeouts, a->pending->len);
+            continue;
+        }
+
+        g_message("  %s: n=%" G_GUINT64_FORMAT " min=%" G_GINT64_FORMAT "ms avg=%" G_GINT64_FORMAT
+                  "ms max=%" G_GINT64_FORMAT "ms p50<%" G_GUINT64_FORMAT "ms p90<%" G_GUINT64_FORMAT
+                  "ms timeouts=%" G_GUINT64_FORMAT,
+                  (const char *)keys[i], a->count, a->min_us / 1000,
+                  a->sum_us / (gint64)a->count / 1000, a->max_us / 1000,
+                  hist_quantile(a, 0.5), hist_quantile(a, 0.9), a->timeouts);
+
+        GString *h = g_string_new(NULL);
+        for (guint b = 0; b < LAUNCH_HIST_BUCKETS; b++) {
+            if (!a->hist[b]) continue;
+            g_string_append_printf(h, " <%" G_GUINT64_FORMAT "ms:%u", (guint64)1 << (b + 1), a->hist[b]);
+        }
+        g_message("   %s", h->str);
+        g_string_free(h, TRUE);
+    }
+    g_free(keys);
+}
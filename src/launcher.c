@@ -2,7 +2,6 @@
 
 #include <gtk/gtk.h>
 #include <gio/gio.h>
-#include <gio-unix-2.0/gio/gdesktopappinfo.h>
 #include <glib.h>
 #include <string.h>
 
@@ -121,36 +120,49 @@ static char **build_terminal_argv(char **cmd_argv) {
     return outv;
 }
 
-void on_app_clicked(GtkButton *b, gpointer user_data) {
-    (void)b;
-    const char *desktop_id = (const char*)user_data;
+// GIO launches regular entries from the file the index read them from,
+// startup notification / activation token, DBusActivatable, %i %c %k and
+// GIO_LAUNCHED_DESKTOP_FILE all come with it.
+static gboolean launch_app_info(GAppInfo *app, const char *desktop_id) {
+    GdkDisplay *dpy = gdk_display_get_default();
+    GAppLaunchContext *ctx = dpy ? G_APP_LAUNCH_CONTEXT(gdk_display_get_app_launch_context(dpy)) : NULL;
 
-    GDesktopAppInfo *app = g_desktop_app_info_new(desktop_id);
-    if (!app) {
-        g_warning("No desktop entry found: %s", desktop_id);
-        return;
+    GError *err = NULL;
+    gboolean ok = g_app_info_launch(app, NULL, ctx, &err);
+    if (!ok) {
+        g_warning("launch failed for %s: %s", desktop_id, err->message);
+        g_error_free(err);
     }
 
-    gboolean terminal = g_desktop_app_info_get_boolean(app, "Terminal");
+    g_clear_object(&ctx);
+    return ok;
+}
 
-    if (!terminal) {
-        GError *err = NULL;
-        if (!g_app_info_launch(G_APP_INFO(app), NULL, NULL, &err)) {
-            if (err) {
-                g_warning("launch failed for %s: %s", desktop_id, err->message);
-                g_error_free(err);
-            }
+// Looks the entry up in the index; Terminal=true entries are spawned inside
+// a terminal emulator from the indexed Exec line, everything else goes
+// through GIO. Returns FALSE (after logging why) if nothing was started.
+gboolean launcher_launch(DesktopIndex *apps, const char *desktop_id) {
+    int i = desktop_index_lookup(apps, desktop_id);
+    if (i < 0) {
+        g_warning("No desktop entry found: %s", desktop_id);
+        return FALSE;
+    }
+
+    if (!(desktop_index_flags(apps, (guint)i) & DESKTOP_ENTRY_TERMINAL)) {
+        // Loaded once per entry and kept by the index.
+        GAppInfo *app = desktop_index_app_info(apps, (guint)i);
+        if (!app) {
+            g_warning("cannot load desktop entry %s from %s", desktop_id,
+                      desktop_index_get(apps, (guint)i, DESKTOP_FIELD_FILE));
+            return FALSE;
         }
-        g_object_unref(app);
-        return;
+        return launch_app_info(app, desktop_id);
     }
 
-    // Terminal=true: manually spawn inside a terminal emulator
-    const char *exec = g_desktop_app_info_get_string(app, "Exec");
-    if (!exec || !*exec) {
-        g_warning("desktop entry %s has Terminal=true but no Exec", desktop_id);
-        g_object_unref(app);
-        return;
+    const char *exec = desktop_index_get(apps, (guint)i, DESKTOP_FIELD_EXEC);
+    if (!*exec) {
+        g_warning("desktop entry %s has no Exec", desktop_id);
+        return FALSE;
     }
 
     char *clean = strip_desktop_field_codes(exec);
@@ -162,8 +174,7 @@ void on_app_clicked(GtkButton *b, gpointer user_data) {
         g_warning("failed to parse Exec for %s: %s", desktop_id, err->message);
         g_error_free(err);
         g_free(clean);
-        g_object_unref(app);
-        return;
+        return FALSE;
     }
     g_free(clean);
 
@@ -172,15 +183,17 @@ void on_app_clicked(GtkButton *b, gpointer user_data) {
 
     if (!targv) {
         g_warning("Terminal=true for %s, but no terminal emulator found", desktop_id);
-        g_object_unref(app);
-        return;
+        return FALSE;
     }
+    argv = targv;
 
-    if (!g_spawn_async(NULL, targv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, NULL, &err)) {
+    const char *workdir = desktop_index_get(apps, (guint)i, DESKTOP_FIELD_WORKDIR);
+    gboolean ok = g_spawn_async(*workdir ? workdir : NULL, argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, NULL, &err);
+    if (!ok) {
         g_warning("terminal launch failed for %s: %s", desktop_id, err->message);
         g_error_free(err);
     }
 
-    g_strfreev(targv);
-    g_object_unref(app);
+    g_strfreev(argv);
+    return ok;
 }
@@ -0,0 +1,72 @@
+#include "line_framer.h"
+
+#include <string.h>
+
+#define MASK (LINE_FRAMER_SIZE - 1)
+
+LineFramer *line_framer_new(void) {
+    return g_new0(LineFramer, 1);
+}
+
+void line_framer_free(LineFramer *f) {
+    g_free(f);
+}
+
+void line_framer_reset(LineFramer *f) {
+    f->head = f->tail = f->scanned = 0;
+    f->discarding = FALSE;
+}
+
+char *line_framer_reserve(LineFramer *f, gsize *avail) {
+    gsize space = LINE_FRAMER_SIZE - (f->tail - f->head);
+    gsize off = f->tail & MASK;
+
+    *avail = MIN(space, LINE_FRAMER_SIZE - off);
+    return f->buf + off;
+}
+
+void line_framer_commit(LineFramer *f, gsize n) {
+    f->tail += n;
+}
+
+gboolean line_framer_next(LineFramer *f, const char **line, gsize *len) {
+    while (f->scanned < f->tail) {
+        gsize off = f->scanned & MASK;
+        gsize n = MIN(f->tail - f->scanned, LINE_FRAMER_SIZE - off);
+
+        const char *nl = memchr(f->buf + off, '\n', n);
+        if (!nl) {
+            f->scanned += n;
+            continue;
+        }
+
+        gsize start = f->head;
+        gsize end = f->scanned + (gsize)(nl - (f->buf + off));
+        f->head = f->scanned = end + 1;
+
+        if (f->discarding) {
+            f->discarding = FALSE;
+            continue;
+        }
+
+        gsize l = end - start;
+        gsize soff = start & MASK;
+        if (soff + l <= LINE_FRAMER_SIZE) {
+            *line = f->buf + soff;
+        } else {
+            gsize first = LINE_FRAMER_SIZE - soff;
+            memcpy(f->joined, f->buf + soff, first);
+            memcpy(f->joined + first, f->buf, l - first);
+            *line = f->joined;
+        }
+        *len = l;
+        return TRUE;
+    }
+
+    // Ring full without a newline: no line can fit, so drop it up to its end.
+    if (f->tail - f->head == LINE_FRAMER_SIZE) {
+        f->head = f->scanned = f->tail;
+        f->discarding = TRUE;
+    }
+    return FALSE;
+}
@@ -0,0 +1,67 @@
+#include "poller.h"
+
+#include <string.h>
+
+#include "dock.h"
+#include "hypr_ipc.h"
+
+#define FNV_OFFSET 14695981039346656037ULL
+
+// FNV-1a, continued from h: enough to tell whether two replies differ.
+static guint64 reply_hash(guint64 h, const char *s, gsize len) {
+    for (gsize i = 0; i < len; i++) {
+        h ^= (guchar)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static gboolean poll_tick_cb(gpointer data) {
+    AppState *st = data;
+    st->poll_id = 0;
+
+    const DockConfig *cfg = st->cfg;
+    guint interval = st->poll_interval_ms;
+
+    // Workspaces and monitors come in the same batch as the clients, so a
+    // changed reply rebuilds the whole table the way a resync does; a
+    // workspace created or moved while polling can't leave it stale.
+    char **r = hypr_ipc_batch(wintable_resync_requests, WINTABLE_RESYNC_REQUESTS);
+    if (r) {
+        guint64 h = FNV_OFFSET;
+        for (guint i = 0; i < WINTABLE_RESYNC_REQUESTS; i++) h = reply_hash(h, r[i], strlen(r[i]));
+
+        if (h != st->poll_hash) {
+            st->poll_hash = h;
+            wintable_apply_resync(st->windows, r);
+            dock_schedule_update(st);
+            interval = (guint)cfg->poll_min_ms;
+        } else {
+            // Unchanged: no parse, no GTK work; just wait longer next time.
+            interval = (guint)MIN((double)cfg->poll_max_ms, interval * cfg->poll_backoff);
+        }
+        g_strfreev(r);
+    } else {
+        interval = (guint)cfg->poll_max_ms;
+    }
+
+    st->poll_interval_ms = MAX(interval, (guint)cfg->poll_min_ms);
+    st->poll_id = g_timeout_add(st->poll_interval_ms, poll_tick_cb, st);
+    return G_SOURCE_REMOVE;
+}
+
+void poller_start(AppState *st) {
+    if (!st || st->poll_id) return;
+
+    // Force the first reply to count as a change.
+    st->poll_hash = 0;
+    st->poll_interval_ms = (guint)st->cfg->poll_min_ms;
+    st->poll_id = g_idle_add(poll_tick_cb, st);
+}
+
+void poller_stop(AppState *st) {
+    if (!st || !st->poll_id) return;
+
+    g_source_remove(st->poll_id);
+    st->poll_id = 0;
+}
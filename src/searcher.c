@@ -1,17 +1,31 @@
 #include "state.h"
+#include "searcher.h"
+#include "hypr.h"
+#include "desktop_match.h"
+#include "launcher.h"
+#include "icon_cache.h"
 #include <gtk/gtk.h>
 #include <gtk4-layer-shell/gtk4-layer-shell.h>
 #include <gio/gio.h>
 #include <gdk/gdkkeysyms.h>
+#include <string.h>
 
+// Launches the app, or in window mode focuses the window, behind a child.
 static void launch_child(AppState *st, GtkWidget *child) {
 	if (!child) return;
 	GtkWidget *vbox = gtk_flow_box_child_get_child(GTK_FLOW_BOX_CHILD(child));
-	GAppInfo *info = g_object_get_data(G_OBJECT(vbox), "app-info");
+	const char *desktop_id = g_object_get_data(G_OBJECT(vbox), "desktop-id");
+	gpointer addr = g_object_get_data(G_OBJECT(vbox), "win-address");
 
-	if (info) {
-		g_app_info_launch(info, NULL, NULL, NULL);
+	if (desktop_id) {
+		if (launcher_launch(st->apps, desktop_id)) {
+			launch_stats_begin(st->launches, desktop_match_key(st->apps, desktop_id));
+		}
 		gtk_widget_set_visible(st->search_box, FALSE);
+	} else if (addr) {
+		// Hide first so the compositor can hand keyboard focus straight over.
+		gtk_widget_set_visible(st->search_box, FALSE);
+		hypr_focus_window((guint64)GPOINTER_TO_SIZE(addr));
 	}
 }
 
@@ -100,79 +114,243 @@ static gboolean on_key_pressed(GtkEventControllerKey *controller,
     return FALSE;
 }
 
+// Every child carries a lowercased "search-key" built once when the list is
+// filled, and the query is lowercased once per change: filtering is then a
+// strstr() per child with no allocation, even over hundreds of windows.
 static gboolean search_filter_func(GtkFlowBoxChild *child, gpointer user_data) {
-    GtkSearchEntry *entry = GTK_SEARCH_ENTRY(user_data);
-    const char *text = gtk_editable_get_text(GTK_EDITABLE(entry));
-    
-    if (!text || !*text) return TRUE; 
-
-    GtkWidget *btn = gtk_flow_box_child_get_child(child);
-    GAppInfo *info = g_object_get_data(G_OBJECT(btn), "app-info");
-    if (!info) return FALSE;
+    AppState *st = (AppState *)user_data;
+    const char *query = st->search_query;
 
-    const char *name = g_app_info_get_name(info);
-    const char *id = g_app_info_get_id(info);
-    
-    char *lower_text = g_ascii_strdown(text, -1);
-    char *lower_name = name ? g_ascii_strdown(name, -1) : NULL;
-    char *lower_id = id ? g_ascii_strdown(id, -1) : NULL;
+    if (!query || !*query) return TRUE;
 
-    gboolean match = (lower_name && strstr(lower_name, lower_text)) ||
-                     (lower_id && strstr(lower_id, lower_text));
+    GtkWidget *vbox = gtk_flow_box_child_get_child(child);
+    const char *key = g_object_get_data(G_OBJECT(vbox), "search-key");
+    return key && strstr(key, query);
+}
 
-    g_free(lower_text);
-    g_free(lower_name);
-    g_free(lower_id);
-    return match;
+static void set_query(AppState *st, const char *text) {
+    g_free(st->search_query);
+    st->search_query = (text && *text) ? g_ascii_strdown(text, -1) : NULL;
+    gtk_flow_box_invalidate_filter(GTK_FLOW_BOX(st->search_flowbox));
 }
 
 static void on_search_changed(GtkSearchEntry *entry, gpointer user_data) {
-    GtkFlowBox *box = GTK_FLOW_BOX(user_data);
-    gtk_flow_box_invalidate_filter(box);
+    AppState *st = (AppState *)user_data;
+    set_query(st, gtk_editable_get_text(GTK_EDITABLE(entry)));
 }
 
-static void searcher_refresh_apps(AppState *st) {
-	if (!st || !st->search_flowbox) return;
+// "a\nb", lowercased; the newline keeps a query from matching across the two.
+static char *make_search_key(const char *a, const char *b) {
+    char *joined = g_strjoin("\n", a ? a : "", b ? b : "", NULL);
+    char *key = g_ascii_strdown(joined, -1);
+    g_free(joined);
+    return key;
+}
 
+static void clear_flowbox(AppState *st) {
 	GtkWidget *child = gtk_widget_get_first_child(st->search_flowbox);
 	while (child) {
 		GtkWidget *next = gtk_widget_get_next_sibling(child);
 		gtk_flow_box_remove(GTK_FLOW_BOX(st->search_flowbox), child);
 		child = next;
 	}
+}
+
+// Through the icon cache, so reopening the searcher, or showing an icon the
+// dock already has, reuses the texture.
+static GtkWidget *make_icon(AppState *st, GIcon *gicon) {
+	int size = st->cfg->searcher_icon_size;
+	GtkWidget *img;
+	if (gicon) {
+		img = gtk_image_new();
+		icon_cache_set_image(GTK_IMAGE(img), gicon, size, icon_cache_display_scale());
+	} else {
+		img = gtk_image_new();
+	}
+	gtk_image_set_pixel_size(GTK_IMAGE(img), size);
+	return img;
+}
+
+// The strings attached below are borrowed from the desktop index and are
+// re-pointed by searcher_apps_changed() when it is replaced.
+static void set_app_data(GtkWidget *child, const DesktopIndex *apps, guint i) {
+	GtkWidget *vbox = gtk_flow_box_child_get_child(GTK_FLOW_BOX_CHILD(child));
+	g_object_set_data(G_OBJECT(vbox), "desktop-id", (gpointer)desktop_index_get(apps, i, DESKTOP_FIELD_ID));
+	g_object_set_data(G_OBJECT(vbox), "search-key", (gpointer)desktop_index_get(apps, i, DESKTOP_FIELD_SEARCH_KEY));
+}
+
+static GtkWidget *make_app_child(AppState *st, guint i) {
+	DesktopIndex *apps = st->apps;
+
+	GtkWidget *child = gtk_flow_box_child_new();
+	gtk_widget_add_css_class(child, "app-btn");
+	gtk_widget_set_focusable(child, TRUE);
+
+	GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+	gtk_widget_set_halign(vbox, GTK_ALIGN_CENTER);
+	gtk_widget_set_valign(vbox, GTK_ALIGN_END);
+	GtkWidget *img = make_icon(st, desktop_index_icon(apps, i));
+
+	GtkWidget *lbl = gtk_label_new(desktop_index_get(apps, i, DESKTOP_FIELD_NAME));
+	gtk_label_set_wrap(GTK_LABEL(lbl), TRUE);
+	gtk_label_set_max_width_chars(GTK_LABEL(lbl), 12);
+
+	gtk_box_append(GTK_BOX(vbox), img);
+	gtk_box_append(GTK_BOX(vbox), lbl);
+
+	gtk_flow_box_child_set_child(GTK_FLOW_BOX_CHILD(child), vbox);
+	set_app_data(child, apps, i);
+
+	// Kept while the window list borrows the flowbox.
+	return g_object_ref_sink(child);
+}
+
+// App children are built once from the desktop index, kept across opens and
+// mode switches, and only touched again for entries that change.
+static void searcher_refresh_apps(AppState *st) {
+	if (!st || !st->search_flowbox) return;
+
+	if (!st->search_apps) {
+		st->search_apps = g_ptr_array_new_with_free_func(g_object_unref);
+		DesktopIndex *apps = st->apps;
+		for (guint i = 0; apps && i < apps->n; i++) {
+			if (desktop_index_listed(apps, i)) g_ptr_array_add(st->search_apps, make_app_child(st, i));
+		}
+	}
+
+	// Already showing them (the last open was in app mode): nothing to do.
+	GtkWidget *first = gtk_widget_get_first_child(st->search_flowbox);
+	if (st->search_apps->len > 0 && first == g_ptr_array_index(st->search_apps, 0)) return;
+
+	clear_flowbox(st);
+	for (guint i = 0; i < st->search_apps->len; i++) {
+		gtk_flow_box_append(GTK_FLOW_BOX(st->search_flowbox), g_ptr_array_index(st->search_apps, i));
+	}
+}
+
+void searcher_apps_changed(AppState *st, const GArray *changes) {
+	if (!st || !st->search_apps || !changes || changes->len == 0) return;
+
+	GHashTable *dirty = g_hash_table_new(g_str_hash, g_str_equal);
+	for (guint i = 0; i < changes->len; i++) {
+		g_hash_table_add(dirty, (gpointer)g_array_index(changes, DesktopChange, i).id);
+	}
+
+	// Untouched children by desktop id (keys still point into the old index).
+	GHashTable *keep = g_hash_table_new(g_str_hash, g_str_equal);
+	for (guint i = 0; i < st->search_apps->len; i++) {
+		GtkWidget *child = g_ptr_array_index(st->search_apps, i);
+		GtkWidget *vbox = gtk_flow_box_child_get_child(GTK_FLOW_BOX_CHILD(child));
+		const char *id = g_object_get_data(G_OBJECT(vbox), "desktop-id");
+		if (!g_hash_table_contains(dirty, id)) g_hash_table_insert(keep, (gpointer)id, child);
+	}
+
+	// Same order as the index; the others' relative order is unchanged.
+	GPtrArray *next = g_ptr_array_new_with_free_func(g_object_unref);
+	DesktopIndex *apps = st->apps;
+	guint created = 0;
+	for (guint i = 0; i < apps->n; i++) {
+		if (!desktop_index_listed(apps, i)) continue;
+		GtkWidget *child = g_hash_table_lookup(keep, desktop_index_get(apps, i, DESKTOP_FIELD_ID));
+		if (child) {
+			set_app_data(child, apps, i);
+			g_ptr_array_add(next, g_object_ref(child));
+		} else {
+			g_ptr_array_add(next, make_app_child(st, i));
+			created++;
+		}
+	}
+	g_hash_table_destroy(keep);
+	g_hash_table_destroy(dirty);
+
+	// If the flowbox holds them (app mode), swap only the children that changed.
+	GtkFlowBox *flow = GTK_FLOW_BOX(st->search_flowbox);
+	if (st->search_mode == SEARCH_MODE_APPS) {
+		GHashTable *live = g_hash_table_new(NULL, NULL);
+		for (guint i = 0; i < next->len; i++) g_hash_table_add(live, g_ptr_array_index(next, i));
+		for (guint i = 0; i < st->search_apps->len; i++) {
+			GtkWidget *child = g_ptr_array_index(st->search_apps, i);
+			if (!g_hash_table_contains(live, child)) gtk_flow_box_remove(flow, child);
+		}
+		g_hash_table_destroy(live);
+
+		for (guint i = 0; i < next->len; i++) {
+			GtkWidget *child = g_ptr_array_index(next, i);
+			if (!gtk_widget_get_parent(child)) gtk_flow_box_insert(flow, child, (int)i);
+		}
+	}
+
+	g_debug("searcher: %u desktop entries changed, %u children built", changes->len, created);
+	g_ptr_array_free(st->search_apps, TRUE);
+	st->search_apps = next;
+}
+
+// Most recently focused first, with the focused window itself last so the
+// first entry is the one to switch back to.
+static gint cmp_switch_order(gconstpointer a, gconstpointer b, gpointer user_data) {
+    const WinEntry *x = *(WinEntry *const *)a;
+    const WinEntry *y = *(WinEntry *const *)b;
+    guint64 active = *(const guint64 *)user_data;
+
+    if ((x->address == active) != (y->address == active)) return (x->address == active) ? 1 : -1;
+    return (x->focus_seq < y->focus_seq) ? 1 : (x->focus_seq > y->focus_seq) ? -1 : 0;
+}
+
+// Fills the flowbox from the window table, which socket2 events keep
+// current, so opening the switcher costs no IPC round trip (except on
+// compositors too old to send windowtitlev2, see titles_stale).
+static void searcher_refresh_windows(AppState *st) {
+	if (!st || !st->search_flowbox || !st->windows) return;
+
+	clear_flowbox(st);
+
+	WinTable *t = st->windows;
+	// Only a compositor without windowtitlev2 gets here with stale titles.
+	if (t->titles_stale) wintable_resync(t);
+
+	GPtrArray *order = g_ptr_array_sized_new(t->wins->len);
+	for (guint i = 0; i < t->wins->len; i++) {
+		g_ptr_array_add(order, &g_array_index(t->wins, WinEntry, i));
+	}
+	g_ptr_array_sort_with_data(order, cmp_switch_order, &t->active);
+
+	GtkIconTheme *theme = gtk_icon_theme_get_for_display(gdk_display_get_default());
 
-	GList *apps = g_app_info_get_all();
-	for (GList *l = apps; l != NULL; l = l->next) {
-		GAppInfo *info = (GAppInfo*)l->data;
-		if (!g_app_info_should_show(info)) continue;
+	for (guint i = 0; i < order->len; i++) {
+		const WinEntry *w = g_ptr_array_index(order, i);
+		const char *cls = wintable_class_key(t, w->cls);
+		const char *title = (w->title && *w->title) ? w->title : cls;
 
 		GtkWidget *child = gtk_flow_box_child_new();
 		gtk_widget_add_css_class(child, "app-btn");
+		gtk_widget_add_css_class(child, "win-btn");
 		gtk_widget_set_focusable(child, TRUE);
 
 		GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
 		gtk_widget_set_halign(vbox, GTK_ALIGN_CENTER);
 		gtk_widget_set_valign(vbox, GTK_ALIGN_END);
-		GIcon *icon = g_app_info_get_icon(info);
 
-		GtkWidget *img = gtk_image_new_from_gicon(icon);
-		gtk_image_set_pixel_size(GTK_IMAGE(img), st->cfg->searcher_icon_size);
+		// Classes usually double as icon names; fall back to a generic one.
+		const char *icon = (cls && *cls && gtk_icon_theme_has_icon(theme, cls)) ? cls : "application-x-executable";
+		GIcon *gicon = g_themed_icon_new(icon);
+		GtkWidget *img = make_icon(st, gicon);
+		g_object_unref(gicon);
 
-		GtkWidget *lbl = gtk_label_new(g_app_info_get_name(info));
+		GtkWidget *lbl = gtk_label_new(title);
 		gtk_label_set_wrap(GTK_LABEL(lbl), TRUE);
+		gtk_label_set_lines(GTK_LABEL(lbl), 2);
+		gtk_label_set_ellipsize(GTK_LABEL(lbl), PANGO_ELLIPSIZE_END);
 		gtk_label_set_max_width_chars(GTK_LABEL(lbl), 12);
 
 		gtk_box_append(GTK_BOX(vbox), img);
 		gtk_box_append(GTK_BOX(vbox), lbl);
-		// gtk_button_set_child(GTK_BUTTON(btn), vbox);
 
 		gtk_flow_box_child_set_child(GTK_FLOW_BOX_CHILD(child), vbox);
-		g_object_set_data_full(G_OBJECT(vbox), "app-info", g_object_ref(info), g_object_unref);
-		// g_signal_connect(btn, "clicked", G_CALLBACK(on_search_app_clicked), st);
+		g_object_set_data(G_OBJECT(vbox), "win-address", GSIZE_TO_POINTER(w->address));
+		g_object_set_data_full(G_OBJECT(vbox), "search-key", make_search_key(w->title, cls), g_free);
 		gtk_flow_box_append(GTK_FLOW_BOX(st->search_flowbox), child);
 	}
-	g_list_free_full(apps, g_object_unref);
-
+	g_ptr_array_free(order, TRUE);
 }
 
 void searcher_init(AppState *st) {
@@ -225,32 +403,49 @@ void searcher_init(AppState *st) {
 
 		searcher_refresh_apps(st);
 
-    gtk_flow_box_set_filter_func(GTK_FLOW_BOX(flow), search_filter_func, entry, NULL);
-    g_signal_connect(entry, "search-changed", G_CALLBACK(on_search_changed), flow);
+    gtk_flow_box_set_filter_func(GTK_FLOW_BOX(flow), search_filter_func, st, NULL);
+    g_signal_connect(entry, "search-changed", G_CALLBACK(on_search_changed), st);
 
     st->search_box = win;
     gtk_widget_set_visible(win, FALSE);
 }
 
-void searcher_toggle(AppState *st) {
+static void searcher_show(AppState *st, SearchMode mode) {
+		st->search_mode = mode;
+		if (mode == SEARCH_MODE_WINDOWS) searcher_refresh_windows(st);
+		else searcher_refresh_apps(st);
+
+		if (st->search_entry) {
+			gtk_editable_set_text(GTK_EDITABLE(st->search_entry), "");
+		}
+		// search-changed is delayed; don't filter the new list with the old query.
+		set_query(st, NULL);
+
+    gtk_widget_set_visible(st->search_box, TRUE);
+    gtk_window_present(GTK_WINDOW(st->search_box));
+
+		if (st->search_entry) {
+			gtk_widget_grab_focus(st->search_entry);
+		}
+}
+
+// Hides if already showing this mode, otherwise (re)opens in it.
+static void searcher_toggle_mode(AppState *st, SearchMode mode) {
     if (!st || !st->search_box) return;
-    
+
     gboolean visible = gtk_widget_get_visible(st->search_box);
-    
-    if (visible) {
+
+    if (visible && st->search_mode == mode) {
         gtk_widget_set_visible(st->search_box, FALSE);
     } else {
-				searcher_refresh_apps(st);
-
-				if (st->search_entry) {
-					gtk_editable_set_text(GTK_EDITABLE(st->search_entry), "");
-				}
+        searcher_show(st, mode);
+    }
+}
 
-        gtk_widget_set_visible(st->search_box, TRUE);
-        gtk_window_present(GTK_WINDOW(st->search_box));
+void searcher_toggle(AppState *st) {
+    searcher_toggle_mode(st, SEARCH_MODE_APPS);
+}
 
-				if (st->search_entry) {
-					gtk_widget_grab_focus(st->search_entry);
-				}
-    }
+void searcher_toggle_windows(AppState *st) {
+    searcher_toggle_mode(st, SEARCH_MODE_WINDOWS);
 }
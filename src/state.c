@@ -3,15 +3,24 @@
 #include "config.h"
 #include "dock.h"
 #include "hypr_events.h"
+#include "icon_cache.h"
+#include "icon_pack.h"
 
-AppState *app_state_new(GtkWidget *dock_box)
+AppState *app_state_new(GtkApplication *app)
 {
     AppState *st = g_new0(AppState, 1);
 
-    st->dock_box = dock_box;
+    st->app = app;
 
     // Load config
     st->cfg = dock_config_load();
+    icon_cache_set_budget(st->cfg->icon_cache_bytes);
+
+    // Every .desktop entry, parsed once for the dock, searcher and launcher
+    st->apps = desktop_index_new();
+
+    // Icons rasterized last time, before any dock asks for one
+    icon_pack_load();
 
     // CSS provider (create + attach; then load your style.css)
     st->css = dock_css_provider_create_and_attach();
@@ -19,13 +28,33 @@ AppState *app_state_new(GtkWidget *dock_box)
 
     // runtime init
     st->items = NULL;
+    st->running_full_sync = TRUE;
     st->poll_id = 0;
+		st->poll_interval_ms = 0;
+		st->poll_hash = 0;
     st->refresh_pending = 0;
     st->event_thread = NULL;
 		st->monitors = g_ptr_array_new_with_free_func(g_object_unref);
-		st->event_fd = -1;
+		st->wake_fd = -1;
+		st->want_polling = 0;
 		st->stop_requested = 0;
-		st->refresh_idle_id = 0;
+		st->refresh_source = NULL;
+		st->windows = wintable_new();
+		st->events = event_queue_new();
+		st->launches = launch_stats_new();
+		st->resync_requested = 0;
+		st->resync_retry_id = 0;
+		st->events_acted = 0;
+		st->events_dropped = 0;
+		st->update_tick_id = 0;
+		st->update_timer_id = 0;
+		st->update_last_request_us = 0;
+		st->update_requests = 0;
+		st->updates_applied = 0;
+		st->updates_merged = 0;
+		st->apps_monitors = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+		st->apps_dirty = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+		st->apps_update_id = 0;
 
     return st;
 }
@@ -36,7 +65,7 @@ void app_state_free(AppState *st)
 
     // Stop subsystems first (they may schedule work against the state)
     hypr_events_stop(st);   // safe no-op if not started
-    dock_shutdown(st);      // frees st->items, etc. (safe no-op if NULL)
+    dock_shutdown(st);      // destroys the dock windows, frees st->items, etc.
 
     if (st->cfg) {
         dock_config_free(st->cfg);
@@ -49,6 +78,15 @@ void app_state_free(AppState *st)
     }
 
 		if (st->monitors) g_ptr_array_free(st->monitors, TRUE);
+		event_queue_free(st->events);
+		wintable_free(st->windows);
+		launch_stats_free(st->launches);
+		if (st->apps_update_id) g_source_remove(st->apps_update_id);
+		g_hash_table_destroy(st->apps_monitors);
+		g_hash_table_destroy(st->apps_dirty);
+		if (st->search_apps) g_ptr_array_free(st->search_apps, TRUE);
+		desktop_index_free(st->apps);
+		g_free(st->search_query);
 
     g_free(st);
 }
@@ -4,9 +4,14 @@
 #include <glib.h>
 
 #include "config.h"   // dock_find_config_path, dock_css_provider_reload
-#include "dock.h"     // idle_rebuild_config
+#include "dock.h"     // idle_rebuild_config, dock_apps_changed, dock_update_icon_pack
+#include "searcher.h" // searcher_apps_changed
 #include "state.h"    // AppState
 
+// Package transactions write many entries in a burst: wait for this much
+// quiet before updating the index once.
+#define APPS_DEBOUNCE_MS 500
+
 static gboolean should_handle_event(GFileMonitorEvent ev) {
     return ev == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT ||
            ev == G_FILE_MONITOR_EVENT_CREATED ||
@@ -84,3 +89,108 @@ void watch_user_file(const char *name, GCallback cb, gpointer user_data)
         (void)m;
     }
 }
+
+/* Application dirs */
+
+static void sync_app_dir_monitors(AppState *st);
+
+// Swaps in an index that re-read only what changed, and tells the dock and
+// searcher which entries differ. The old index stays alive until both
+// have moved their borrowed strings over.
+static gboolean apps_update_cb(gpointer data) {
+    AppState *st = (AppState *)data;
+    st->apps_update_id = 0;
+
+    DesktopIndex *old = st->apps;
+    DesktopIndex *apps = desktop_index_update(st->apps_dirty);
+    g_hash_table_remove_all(st->apps_dirty);
+
+    GArray *changes = desktop_index_diff(old, apps);
+    g_debug("desktop index: update read %u dirs, %u entries changed", apps->dirs_read, changes->len);
+
+    // Dirs may have come or gone even if no entry changed.
+    st->apps = apps;
+    sync_app_dir_monitors(st);
+
+    if (changes->len > 0) {
+        dock_apps_changed(st, changes);
+        searcher_apps_changed(st, changes);
+        desktop_index_carry_over(apps, old, changes);
+        desktop_index_free(old);
+        dock_update_icon_pack(st);
+    } else {
+        // Nothing to tell: keep the old one, which everything still points into.
+        st->apps = old;
+        desktop_index_free(apps);
+    }
+    g_array_free(changes, TRUE);
+    return G_SOURCE_REMOVE;
+}
+
+static void on_app_dir_changed(GFileMonitor *mon,
+                               GFile *file,
+                               GFile *other,
+                               GFileMonitorEvent ev,
+                               gpointer user_data)
+{
+    (void)mon; (void)other;
+
+    AppState *st = (AppState *)user_data;
+    if (!st) return;
+    if (ev == G_FILE_MONITOR_EVENT_CHANGED || ev == G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED
+        || ev == G_FILE_MONITOR_EVENT_PRE_UNMOUNT) return;
+
+    // An entry rewritten in place leaves its dir's mtime alone: name the
+    // dir so it is read again. Anything else (entries or subdirs added,
+    // removed or renamed) shows in the mtime.
+    char *name = g_file_get_basename(file);
+    if (name && g_str_has_suffix(name, ".desktop")) {
+        GFile *parent = g_file_get_parent(file);
+        if (parent) {
+            g_hash_table_add(st->apps_dirty, g_file_get_path(parent));
+            g_object_unref(parent);
+        }
+    }
+    g_free(name);
+
+    if (st->apps_update_id) g_source_remove(st->apps_update_id);
+    st->apps_update_id = g_timeout_add(APPS_DEBOUNCE_MS, apps_update_cb, st);
+}
+
+// One monitor per dir the index scanned, nested vendor dirs included; dirs
+// that do not exist yet are watched too, so creating them is noticed.
+static void sync_app_dir_monitors(AppState *st) {
+    GHashTable *want = g_hash_table_new(g_str_hash, g_str_equal);
+    for (char **d = st->apps->dirs; d && *d; d++) g_hash_table_add(want, *d);
+
+    GHashTableIter iter;
+    gpointer path;
+    g_hash_table_iter_init(&iter, st->apps_monitors);
+    while (g_hash_table_iter_next(&iter, &path, NULL)) {
+        if (!g_hash_table_contains(want, path)) g_hash_table_iter_remove(&iter);
+    }
+
+    for (char **d = st->apps->dirs; d && *d; d++) {
+        if (g_hash_table_contains(st->apps_monitors, *d)) continue;
+
+        GFile *f = g_file_new_for_path(*d);
+        GError *err = NULL;
+        GFileMonitor *m = g_file_monitor_directory(f, G_FILE_MONITOR_WATCH_MOVES, NULL, &err);
+        g_object_unref(f);
+        if (!m) {
+            g_warning("monitor failed for %s: %s", *d, err->message);
+            g_error_free(err);
+            continue;
+        }
+        g_signal_connect(m, "changed", G_CALLBACK(on_app_dir_changed), st);
+        g_hash_table_insert(st->apps_monitors, g_strdup(*d), m);
+    }
+    g_hash_table_destroy(want);
+}
+
+void watch_application_dirs(AppState *st)
+{
+    if (!st || !st->apps) return;
+    sync_app_dir_monitors(st);
+    g_debug("desktop index: watching %u dirs", g_hash_table_size(st->apps_monitors));
+}
@@ -0,0 +1,596 @@
+#include "wintable.h"
+#include "hypr.h"
+#include "hypr_ipc.h"
+#include "intern.h"
+
+#include <string.h>
+
+// Addresses are 64-bit; the dock only targets 64-bit compositors.
+#define ADDR_KEY(a) GSIZE_TO_POINTER((gsize)(a))
+
+typedef struct {
+    gint32 id;
+    gint32 monitor;     // slot
+} WsInfo;
+
+WinTable *wintable_new(void) {
+    WinTable *t = g_new0(WinTable, 1);
+    t->wins = g_array_new(FALSE, FALSE, sizeof(WinEntry));
+    t->win_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+    t->classes = g_array_new(FALSE, TRUE, sizeof(ClassEntry));
+    t->changed = g_array_new(FALSE, FALSE, sizeof(guint32));
+    t->class_ids = g_hash_table_new(g_direct_hash, g_direct_equal);
+    t->ws_by_name = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    t->mon_ids = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    for (int i = 0; i < WINTABLE_MAX_MONITORS; i++) t->mon_slot_ids[i] = -1;
+    t->focused_mon = -1;
+    return t;
+}
+
+// Class counts moved; see WinTable.changed.
+static void mark_changed(WinTable *t, guint32 id) {
+    ClassEntry *c = &g_array_index(t->classes, ClassEntry, id);
+    if (c->changed) return;
+    c->changed = TRUE;
+    g_array_append_val(t->changed, id);
+}
+
+static void clear_windows(WinTable *t) {
+    for (guint i = 0; i < t->wins->len; i++) {
+        g_free(g_array_index(t->wins, WinEntry, i).title);
+    }
+    g_array_set_size(t->wins, 0);
+    g_hash_table_remove_all(t->win_index);
+
+    for (guint i = 0; i < t->classes->len; i++) {
+        ClassEntry *c = &g_array_index(t->classes, ClassEntry, i);
+        if (c->count) mark_changed(t, i);
+        c->count = 0;
+        memset(c->per_mon, 0, sizeof(c->per_mon));
+        if (c->per_ws) g_array_set_size(c->per_ws, 0);
+        if (c->wins) g_array_set_size(c->wins, 0);
+    }
+    memset(t->mon_slot_wins, 0, sizeof(t->mon_slot_wins));
+    t->active = 0;
+}
+
+void wintable_free(WinTable *t) {
+    if (!t) return;
+    clear_windows(t);
+    for (guint i = 0; i < t->classes->len; i++) {
+        ClassEntry *c = &g_array_index(t->classes, ClassEntry, i);
+        if (c->per_ws) g_array_free(c->per_ws, TRUE);
+        if (c->wins) g_array_free(c->wins, TRUE);
+    }
+    g_array_free(t->wins, TRUE);
+    g_hash_table_destroy(t->win_index);
+    g_array_free(t->classes, TRUE);
+    g_array_free(t->changed, TRUE);
+    g_hash_table_destroy(t->class_ids);
+    g_hash_table_destroy(t->ws_by_name);
+    g_hash_table_destroy(t->mon_ids);
+    g_free(t);
+}
+
+/* Interning and accounting */
+
+// cls is interned, so the table compares pointers.
+static guint32 class_id(WinTable *t, const char *cls) {
+    gpointer v = g_hash_table_lookup(t->class_ids, cls);
+    if (v) return GPOINTER_TO_UINT(v) - 1;
+
+    ClassEntry ce = { .key = cls };
+    g_array_append_val(t->classes, ce);
+
+    guint32 id = t->classes->len - 1;
+    g_hash_table_insert(t->class_ids, (gpointer)cls, GUINT_TO_POINTER(id + 1));
+    return id;
+}
+
+static ClassEntry *class_lookup(WinTable *t, const char *cls) {
+    if (!cls) return NULL;
+    gpointer v = g_hash_table_lookup(t->class_ids, cls);
+    return v ? &g_array_index(t->classes, ClassEntry, GPOINTER_TO_UINT(v) - 1) : NULL;
+}
+
+// A class sits on a handful of workspaces at most: linear scan, and
+// workspaces it left are dropped so the array stays that short.
+static void ws_account(ClassEntry *c, gint32 ws, int delta) {
+    if (!c->per_ws) c->per_ws = g_array_sized_new(FALSE, FALSE, sizeof(WinWsCount), 2);
+
+    for (guint i = 0; i < c->per_ws->len; i++) {
+        WinWsCount *wc = &g_array_index(c->per_ws, WinWsCount, i);
+        if (wc->workspace_id != ws) continue;
+        wc->count += delta;
+        if (wc->count == 0) g_array_remove_index_fast(c->per_ws, i);
+        return;
+    }
+    if (delta > 0) {
+        WinWsCount wc = { .workspace_id = ws, .count = (guint32)delta };
+        g_array_append_val(c->per_ws, wc);
+    }
+}
+
+static void account(WinTable *t, const WinEntry *w, int delta) {
+    ClassEntry *c = &g_array_index(t->classes, ClassEntry, w->cls);
+    c->count += delta;
+    if (w->monitor >= 0) {
+        c->per_mon[w->monitor] += delta;
+        t->mon_slot_wins[w->monitor] += delta;
+    }
+    ws_account(c, w->workspace_id, delta);
+}
+
+/* Monitor slots */
+
+static int mon_slot(WinTable *t, gint32 id) {
+    if (id < 0) return -1;
+    for (int i = 0; i < WINTABLE_MAX_MONITORS; i++) {
+        if (t->mon_slot_ids[i] == id) return i;
+    }
+    return -1;
+}
+
+// A freed slot is only reused once no window is counted in it any more:
+// windows of a removed monitor stay there until their workspaces move.
+static int mon_slot_add(WinTable *t, gint32 id, const char *name) {
+    int slot = mon_slot(t, id);
+    for (int i = 0; slot < 0 && i < WINTABLE_MAX_MONITORS; i++) {
+        if (t->mon_slot_ids[i] < 0 && t->mon_slot_wins[i] == 0) slot = i;
+    }
+    if (slot < 0) return -1;
+
+    t->mon_slot_ids[slot] = id;
+    g_hash_table_replace(t->mon_ids, g_strdup(name), GINT_TO_POINTER(slot + 1));
+    return slot;
+}
+
+// Per-class address lists are short (a class rarely has more than a few
+// windows), so a linear remove is fine.
+static void class_link(WinTable *t, const WinEntry *w) {
+    ClassEntry *c = &g_array_index(t->classes, ClassEntry, w->cls);
+    if (!c->wins) c->wins = g_array_sized_new(FALSE, FALSE, sizeof(guint64), 2);
+    g_array_append_val(c->wins, w->address);
+}
+
+static void class_unlink(WinTable *t, const WinEntry *w) {
+    GArray *list = g_array_index(t->classes, ClassEntry, w->cls).wins;
+    if (!list) return;
+    for (guint i = 0; i < list->len; i++) {
+        if (g_array_index(list, guint64, i) == w->address) {
+            g_array_remove_index_fast(list, i);
+            return;
+        }
+    }
+}
+
+static gint win_find(WinTable *t, guint64 addr) {
+    gpointer v = g_hash_table_lookup(t->win_index, ADDR_KEY(addr));
+    return v ? (gint)GPOINTER_TO_UINT(v) - 1 : -1;
+}
+
+static WinEntry *win_get(WinTable *t, guint64 addr) {
+    gint i = win_find(t, addr);
+    return i < 0 ? NULL : &g_array_index(t->wins, WinEntry, i);
+}
+
+static void win_remove_at(WinTable *t, guint i) {
+    WinEntry *w = &g_array_index(t->wins, WinEntry, i);
+    account(t, w, -1);
+    mark_changed(t, w->cls);
+    class_unlink(t, w);
+    g_hash_table_remove(t->win_index, ADDR_KEY(w->address));
+    g_free(w->title);
+
+    // The last entry moves into the hole; re-point its index.
+    g_array_remove_index_fast(t->wins, i);
+    if (i < t->wins->len) {
+        WinEntry *moved = &g_array_index(t->wins, WinEntry, i);
+        g_hash_table_insert(t->win_index, ADDR_KEY(moved->address), GUINT_TO_POINTER(i + 1));
+    }
+}
+
+// Takes ownership of title.
+static void win_put(WinTable *t, guint64 addr, const char *cls, char *title,
+                    gint32 ws, gint32 mon, guint32 focus_seq) {
+    gint old = win_find(t, addr);
+    if (old >= 0) win_remove_at(t, (guint)old);
+
+    WinEntry w = {
+        .address = addr,
+        .title = title,
+        .cls = class_id(t, cls ? cls : intern("")),
+        .workspace_id = ws,
+        .monitor = mon,
+        .focus_seq = focus_seq,
+    };
+    g_array_append_val(t->wins, w);
+    g_hash_table_insert(t->win_index, ADDR_KEY(addr), GUINT_TO_POINTER(t->wins->len));
+    account(t, &w, +1);
+    mark_changed(t, w.cls);
+    class_link(t, &w);
+}
+
+static void win_move(WinTable *t, WinEntry *w, gint32 ws, gint32 mon) {
+    if (w->workspace_id == ws && w->monitor == mon) return;
+    account(t, w, -1);
+    w->workspace_id = ws;
+    w->monitor = mon;
+    account(t, w, +1);
+}
+
+static WsInfo *ws_by_id(WinTable *t, gint32 id, const char **name_out) {
+    GHashTableIter it;
+    gpointer k, v;
+    g_hash_table_iter_init(&it, t->ws_by_name);
+    while (g_hash_table_iter_next(&it, &k, &v)) {
+        if (((WsInfo*)v)->id == id) {
+            if (name_out) *name_out = k;
+            return v;
+        }
+    }
+    return NULL;
+}
+
+/* Resync */
+
+void wintable_replace(WinTable *t, GPtrArray *clients) {
+    if (!t || !clients) return;
+
+    clear_windows(t);
+
+    // focusHistoryID counts back from the most recent window; turn it into
+    // increasing sequence numbers on top of our own clock.
+    guint32 base = t->focus_clock;
+    guint32 n = clients->len;
+
+    for (guint i = 0; i < clients->len; i++) {
+        HyprClient *c = g_ptr_array_index(clients, i);
+        guint32 back = (c->focus_history >= 0) ? MIN((guint32)c->focus_history, n) : n;
+
+        win_put(t, c->address, c->cls, c->title, c->workspace_id, mon_slot(t, c->monitor), base + n - back);
+        c->title = NULL;    // moved into the table
+
+        if (c->focus_history == 0) t->active = c->address;
+    }
+    t->focus_clock = base + n + 1;
+
+    g_ptr_array_free(clients, TRUE);
+    t->resync_needed = FALSE;
+}
+
+const char *const wintable_resync_requests[WINTABLE_RESYNC_REQUESTS] = {
+    "j/clients", "j/workspaces", "j/monitors", "j/activewindow",
+};
+
+void wintable_apply_resync(WinTable *t, char **r) {
+    if (!t || !r) return;
+
+    // Every window is re-added below, so slots can be handed out afresh.
+    clear_windows(t);
+    g_hash_table_remove_all(t->mon_ids);
+    for (int i = 0; i < WINTABLE_MAX_MONITORS; i++) t->mon_slot_ids[i] = -1;
+    t->focused_mon = -1;
+
+    GPtrArray *mons = hypr_parse_monitors(r[2], strlen(r[2]));
+    for (guint i = 0; i < mons->len; i++) {
+        HyprMonitor *m = g_ptr_array_index(mons, i);
+        int slot = mon_slot_add(t, m->id, m->name);
+        // focusedmonv2 never fires with a single monitor
+        if (m->focused) t->focused_mon = slot;
+    }
+    g_ptr_array_free(mons, TRUE);
+
+    g_hash_table_remove_all(t->ws_by_name);
+    GPtrArray *wss = hypr_parse_workspaces(r[1], strlen(r[1]));
+    for (guint i = 0; i < wss->len; i++) {
+        HyprWorkspace *w = g_ptr_array_index(wss, i);
+        WsInfo *info = g_new(WsInfo, 1);
+        info->id = w->id;
+        info->monitor = mon_slot(t, w->monitor);
+        g_hash_table_insert(t->ws_by_name, g_strdup(w->name), info);
+    }
+    g_ptr_array_free(wss, TRUE);
+
+    wintable_replace(t, hypr_parse_clients(r[0], strlen(r[0])));
+
+    guint64 active = hypr_parse_active_address(r[3], strlen(r[3]));
+    if (active) t->active = active;
+    t->titles_stale = FALSE;
+}
+
+gboolean wintable_resync(WinTable *t) {
+    if (!t) return FALSE;
+
+    char **r = hypr_ipc_batch(wintable_resync_requests, WINTABLE_RESYNC_REQUESTS);
+    if (!r) {
+        // A stale table beats an empty dock.
+        t->resync_needed = TRUE;
+        return FALSE;
+    }
+
+    wintable_apply_resync(t, r);
+    g_strfreev(r);
+    return TRUE;
+}
+
+/* Events */
+
+static guint64 parse_address(const char *s) {
+    return s ? g_ascii_strtoull(s, NULL, 16) : 0;
+}
+
+static const char *active_class(WinTable *t) {
+    WinEntry *w = t->active ? win_get(t, t->active) : NULL;
+    return w ? g_array_index(t->classes, ClassEntry, w->cls).key : NULL;
+}
+
+gboolean wintable_apply_event(WinTable *t, WinEvent kind, const char *data) {
+    if (!t || !data) return FALSE;
+
+    switch (kind) {
+    case WIN_EVENT_OPEN_WINDOW: {
+        // ADDRESS,WORKSPACENAME,CLASS,TITLE (title may contain commas)
+        char **f = g_strsplit(data, ",", 4);
+        if (g_strv_length(f) < 3) { g_strfreev(f); return FALSE; }
+
+        guint64 addr = parse_address(f[0]);
+        if (!addr) { g_strfreev(f); return FALSE; }
+
+        WsInfo *ws = g_hash_table_lookup(t->ws_by_name, f[1]);
+        if (!ws) t->resync_needed = TRUE;
+
+        g_strstrip(f[2]);
+        const char *cls = intern_lower(f[2]);
+        // Some clients map before setting a class; pick it up on the next resync.
+        if (!*cls) t->resync_needed = TRUE;
+
+        win_put(t, addr, cls, g_strdup(f[3] ? f[3] : ""),
+                ws ? ws->id : 0, ws ? ws->monitor : -1, t->focus_clock++);
+
+        g_strfreev(f);
+        return TRUE;
+    }
+
+    case WIN_EVENT_CLOSE_WINDOW: {
+        guint64 addr = parse_address(data);
+        gint i = win_find(t, addr);
+        if (i < 0) return FALSE;
+
+        win_remove_at(t, (guint)i);
+        if (t->active == addr) t->active = 0;
+        return TRUE;
+    }
+
+    case WIN_EVENT_ACTIVE_WINDOW: {
+        // ADDRESS (empty when focus leaves all windows)
+        const char *before = active_class(t);
+        guint64 addr = parse_address(data);
+
+        wintable_mark_focused(t, addr);
+        if (addr && !win_get(t, addr)) t->resync_needed = TRUE;
+
+        return before != active_class(t);   // interned: pointer compare
+    }
+
+    case WIN_EVENT_MOVE_WINDOW: {
+        // ADDRESS,WORKSPACEID,WORKSPACENAME
+        char **f = g_strsplit(data, ",", 3);
+        if (g_strv_length(f) < 3) { g_strfreev(f); return FALSE; }
+
+        WinEntry *w = win_get(t, parse_address(f[0]));
+        WsInfo *ws = g_hash_table_lookup(t->ws_by_name, f[2]);
+        gboolean changed = FALSE;
+
+        if (!w || !ws) {
+            t->resync_needed = TRUE;
+        } else {
+            changed = (w->monitor != ws->monitor);
+            win_move(t, w, ws->id, ws->monitor);
+        }
+        g_strfreev(f);
+        return changed;
+    }
+
+    case WIN_EVENT_WINDOW_TITLE: {
+        // ADDRESS,TITLE
+        const char *comma = strchr(data, ',');
+        if (!comma) return FALSE;
+
+        // strtoull stops at the comma
+        WinEntry *w = win_get(t, parse_address(data));
+        if (w) {
+            g_free(w->title);
+            w->title = g_strdup(comma + 1);
+        }
+        t->titles_v2 = TRUE;
+        return FALSE;
+    }
+
+    case WIN_EVENT_WINDOW_TITLE_V1: {
+        // ADDRESS only. Compositors that also send windowtitlev2 are
+        // covered by it; older ones leave the title to be fetched by a
+        // resync, done lazily by whoever shows titles.
+        if (!t->titles_v2 && win_get(t, parse_address(data))) t->titles_stale = TRUE;
+        return FALSE;
+    }
+
+    case WIN_EVENT_CREATE_WORKSPACE: {
+        // ID,NAME: new workspaces open on the focused monitor
+        char **f = g_strsplit(data, ",", 2);
+        if (g_strv_length(f) == 2 && t->focused_mon < 0) {
+            t->resync_needed = TRUE;
+        } else if (g_strv_length(f) == 2) {
+            WsInfo *info = g_new(WsInfo, 1);
+            info->id = (gint32)g_ascii_strtoll(f[0], NULL, 10);
+            info->monitor = t->focused_mon;
+            g_hash_table_replace(t->ws_by_name, g_strdup(f[1]), info);
+        }
+        g_strfreev(f);
+        return FALSE;
+    }
+
+    case WIN_EVENT_DESTROY_WORKSPACE: {
+        // ID,NAME
+        const char *comma = strchr(data, ',');
+        if (comma) g_hash_table_remove(t->ws_by_name, comma + 1);
+        return FALSE;
+    }
+
+    case WIN_EVENT_RENAME_WORKSPACE: {
+        // ID,NEWNAME
+        const char *comma = strchr(data, ',');
+        const char *old_name = NULL;
+        WsInfo *ws = comma ? ws_by_id(t, (gint32)g_ascii_strtoll(data, NULL, 10), &old_name) : NULL;
+        if (ws) {
+            WsInfo *info = g_new(WsInfo, 1);
+            *info = *ws;
+            g_hash_table_remove(t->ws_by_name, old_name);
+            g_hash_table_replace(t->ws_by_name, g_strdup(comma + 1), info);
+        }
+        return FALSE;
+    }
+
+    case WIN_EVENT_MOVE_WORKSPACE: {
+        // ID,NAME,MONNAME: every window on it changes monitor
+        char **f = g_strsplit(data, ",", 3);
+        gboolean changed = FALSE;
+
+        if (g_strv_length(f) == 3) {
+            WsInfo *ws = g_hash_table_lookup(t->ws_by_name, f[1]);
+            int mon = wintable_monitor_slot(t, f[2]);
+            if (!ws || mon < 0) {
+                t->resync_needed = TRUE;
+            } else if (ws->monitor != mon) {
+                ws->monitor = mon;
+                for (guint i = 0; i < t->wins->len; i++) {
+                    WinEntry *w = &g_array_index(t->wins, WinEntry, i);
+                    if (w->workspace_id != ws->id) continue;
+                    win_move(t, w, w->workspace_id, mon);
+                    changed = TRUE;
+                }
+            }
+        }
+        g_strfreev(f);
+        return changed;
+    }
+
+    case WIN_EVENT_FOCUSED_MONITOR: {
+        // MONNAME,WORKSPACEID
+        const char *comma = strchr(data, ',');
+        if (comma) {
+            char *name = g_strndup(data, (gsize)(comma - data));
+            t->focused_mon = wintable_monitor_slot(t, name);
+            g_free(name);
+        }
+        return FALSE;
+    }
+
+    case WIN_EVENT_MONITOR_ADDED: {
+        // ID,NAME,DESCRIPTION
+        char **f = g_strsplit(data, ",", 3);
+        // No free slot: its windows only count in the totals.
+        if (g_strv_length(f) >= 2) mon_slot_add(t, (gint32)g_ascii_strtoll(f[0], NULL, 10), f[1]);
+        g_strfreev(f);
+        return FALSE;
+    }
+
+    case WIN_EVENT_MONITOR_REMOVED: {
+        // ID,NAME,DESCRIPTION; its workspaces arrive via moveworkspacev2
+        char **f = g_strsplit(data, ",", 3);
+        if (g_strv_length(f) >= 2) {
+            int slot = mon_slot(t, (gint32)g_ascii_strtoll(f[0], NULL, 10));
+            if (slot >= 0) t->mon_slot_ids[slot] = -1;
+            g_hash_table_remove(t->mon_ids, f[1]);
+        }
+        g_strfreev(f);
+        return FALSE;
+    }
+
+    case WIN_EVENT_NONE:
+        break;
+    }
+    return FALSE;
+}
+
+/* Lookups */
+
+int wintable_class_count(WinTable *t, const char *cls) {
+    if (!t) return 0;
+    ClassEntry *c = class_lookup(t, cls);
+    return c ? (int)c->count : 0;
+}
+
+int wintable_class_count_on(WinTable *t, const char *cls, int slot) {
+    if (!t || slot < 0 || slot >= WINTABLE_MAX_MONITORS) return 0;
+    ClassEntry *c = class_lookup(t, cls);
+    return c ? c->per_mon[slot] : 0;
+}
+
+int wintable_class_count_ws(WinTable *t, const char *cls, int workspace_id) {
+    if (!t) return 0;
+    ClassEntry *c = class_lookup(t, cls);
+    if (!c || !c->per_ws) return 0;
+
+    for (guint i = 0; i < c->per_ws->len; i++) {
+        WinWsCount *wc = &g_array_index(c->per_ws, WinWsCount, i);
+        if (wc->workspace_id == workspace_id) return (int)wc->count;
+    }
+    return 0;
+}
+
+const char *wintable_active_class(WinTable *t) {
+    return t ? active_class(t) : NULL;
+}
+
+int wintable_monitor_slot(WinTable *t, const char *name) {
+    if (!t || !name) return -1;
+    gpointer v = g_hash_table_lookup(t->mon_ids, name);
+    return v ? GPOINTER_TO_INT(v) - 1 : -1;
+}
+
+const char *wintable_class_key(WinTable *t, guint32 id) {
+    if (!t || id >= t->classes->len) return NULL;
+    return g_array_index(t->classes, ClassEntry, id).key;
+}
+
+void wintable_clear_changed(WinTable *t) {
+    if (!t) return;
+    for (guint i = 0; i < t->changed->len; i++) {
+        guint32 id = g_array_index(t->changed, guint32, i);
+        g_array_index(t->classes, ClassEntry, id).changed = FALSE;
+    }
+    g_array_set_size(t->changed, 0);
+}
+
+void wintable_mark_focused(WinTable *t, guint64 address) {
+    if (!t) return;
+    t->active = address;
+
+    WinEntry *w = address ? win_get(t, address) : NULL;
+    if (w) w->focus_seq = t->focus_clock++;
+}
+
+guint64 wintable_pick_window(WinTable *t, const char *cls) {
+    if (!t) return 0;
+    ClassEntry *c = class_lookup(t, cls);
+    if (!c || !c->wins || c->wins->len == 0) return 0;
+
+    const char *active = active_class(t);
+    gboolean cycling = (active == c->key);
+
+    guint64 best = 0;
+    guint32 best_seq = 0;
+    for (guint i = 0; i < c->wins->len; i++) {
+        guint64 addr = g_array_index(c->wins, guint64, i);
+        WinEntry *w = win_get(t, addr);
+        if (!w) continue;
+
+        gboolean better = !best || (cycling ? w->focus_seq < best_seq : w->focus_seq > best_seq);
+        if (better) {
+            best = addr;
+            best_seq = w->focus_seq;
+        }
+    }
+    return best;
+}